@@ -0,0 +1,55 @@
+// Benchmark of the particle system at a steady particle count.
+// Each frame tops the particles up to the target count, then times tick under the player's gravity
+// and draw on one core, with draw compositing straight into the image.
+//
+// usage: particle_bench [frames] [particles]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "image.h"
+#include "game.h"
+#include "span.h"
+
+int const scr_W = 512;
+int const scr_H = 824;
+
+using Clock = std::chrono::steady_clock;
+
+static double ms(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+int main(int argc, char* argv[]) {
+    int frames = argc > 1 ? atoi(argv[1]) : 1000;
+    int target = argc > 2 ? atoi(argv[2]) : 100000;
+
+    Image image(scr_W, scr_H);
+    Particles particles;
+    float2 const gravity = Player().gravity;
+    float2 const center = { scr_W * 0.5f, scr_H * 0.5f };
+    auto const pixel = image.pack(color8{ 1.0f, 1.0f, 1.0f });
+
+    Clock::duration ticking = {};
+    Clock::duration drawing = {};
+    long long live = 0;
+    for (int f = 0; f < frames; ++f) {
+        particles.emit(center, { 0.0f, 2.0f * __scale }, 4.0f * __scale, target - particles.count, 1.0f, pixel);
+        live += particles.count;
+
+        auto t0 = Clock::now();
+        particles.tick(1.0f / 60.0f, gravity);
+        auto t1 = Clock::now();
+        image.clearDirty(color8{ 0.0f, 0.0f, 0.0f });
+        particles.draw(image, 0);
+        auto t2 = Clock::now();
+        ticking += t1 - t0;
+        drawing += t2 - t1;
+    }
+
+    printf("%d frames, %.0f particles on average, %s kernels\n", frames, (double)live / frames, simdTierName(spanTier()));
+    printf("tick:  %8.4f ms/frame\n", ms(ticking) / frames);
+    printf("draw:  %8.4f ms/frame\n", ms(drawing) / frames);
+    printf("total: %8.4f ms/frame\n", ms(ticking + drawing) / frames);
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Benchmark of the scanline renderer against drawing the game scene directly.
+// Both paths clear the whole frame and draw Game::draw, the scanline result is checked
+// against the direct one every frame.
+//
+// usage: scanline_bench [frames]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "image.h"
+#include "game.h"
+#include "command.h"
+#include "scanline.h"
+
+int const scr_W = 512;
+int const scr_H = 824;
+
+using Clock = std::chrono::steady_clock;
+
+static double ms(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+int main(int argc, char* argv[]) {
+    int frames = argc > 1 ? atoi(argv[1]) : 2000;
+
+    Image image(scr_W, scr_H);
+    Image reference(scr_W, scr_H);
+    srand(1);
+    Game game(image);
+    game.init();
+
+    CommandBuffer commands;
+    ScanlineRenderer scanline;
+    color8 const background = { 0.0f, 0.0f, 0.0f };
+
+    Clock::duration direct = {};
+    Clock::duration scanned = {};
+    int64_t directPixels = 0;
+    int64_t scannedPixels = 0;
+
+    for (int f = 0; f < frames; ++f) {
+        // Jump every half second so the scene scrolls and levels come and go.
+        auto command = f % 30 == 0 ? (f / 30 % 2 ? UserCommand::JumpLeft : UserCommand::JumpRight) : UserCommand::None;
+        if (game.tick(command, 1.0f / 60.0f)) game.init();
+
+        auto t0 = Clock::now();
+        image.fill(background);
+        game.draw();
+        direct += Clock::now() - t0;
+        memcpy(reference.data, image.data, (size_t)image.stride * image.height * sizeof(Image::dataType));
+
+        // Pixels the direct path wrote, every recorded rect clipped to the image.
+        commands.record(image);
+        image.fill(background);
+        game.draw();
+        commands.stop();
+        for (auto const& c : commands.commands) {
+            Rect r = {
+                std::max(c.bounds.x0, 0), std::max(c.bounds.y0, 0),
+                std::min(c.bounds.x1, image.width), std::min(c.bounds.y1, image.height),
+            };
+            directPixels += r.area();
+        }
+
+        memset(image.data, 0x55, (size_t)image.stride * image.height * sizeof(Image::dataType));
+        t0 = Clock::now();
+        scanline.execute(image.view(), commands);
+        scanned += Clock::now() - t0;
+        scannedPixels += scanline.written;
+
+        for (int y = 0; y < image.height; ++y) {
+            if (memcmp(image.data + y * image.stride, reference.data + y * image.stride, image.width * sizeof(Image::dataType))) {
+                printf("frame %d: scanline image differs at row %d\n", f, y);
+                return 1;
+            }
+        }
+    }
+
+    printf("%d frames of %dx%d\n", frames, scr_W, scr_H);
+    printf("direct:   %8.4f ms/frame, %5.2f writes/pixel\n",
+        ms(direct) / frames, (double)directPixels / frames / (scr_W * scr_H));
+    printf("scanline: %8.4f ms/frame, %5.2f writes/pixel\n",
+        ms(scanned) / frames, (double)scannedPixels / frames / (scr_W * scr_H));
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Benchmark of sprite drawing against flat fills of the game scene, and of atlas loading.
+// Both paths clear the whole frame and draw Game::draw directly, once with flat colors
+// and once with the atlas, over the same frames.
+//
+// usage: sprite_bench [frames] [atlas]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "image.h"
+#include "game.h"
+#include "atlas.h"
+
+int const scr_W = 512;
+int const scr_H = 824;
+int const loads = 100;
+
+using Clock = std::chrono::steady_clock;
+
+static double ms(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+int main(int argc, char* argv[]) {
+    int frames = argc > 1 ? atoi(argv[1]) : 2000;
+    char const* path = argc > 2 ? argv[2] : "assets/atlas.ppm";
+
+    Image image(scr_W, scr_H);
+    SpriteAtlas atlas;
+    auto t0 = Clock::now();
+    for (int i = 0; i < loads; ++i) {
+        if (!atlas.load(path, image.format, color8{1.0f, 0.0f, 1.0f})) {
+            printf("cannot load %s\n", path);
+            return 1;
+        }
+    }
+    Clock::duration loading = Clock::now() - t0;
+
+    srand(1);
+    Game game(image);
+    game.init();
+    color8 const background = { 0.0f, 0.0f, 0.0f };
+
+    Clock::duration flat = {};
+    Clock::duration sprites = {};
+    for (int f = 0; f < frames; ++f) {
+        // Jump every half second so the scene scrolls and levels come and go.
+        auto command = f % 30 == 0 ? (f / 30 % 2 ? UserCommand::JumpLeft : UserCommand::JumpRight) : UserCommand::None;
+        if (game.tick(command, 1.0f / 60.0f)) game.init();
+
+        game.atlas = nullptr;
+        t0 = Clock::now();
+        image.fill(background);
+        game.draw();
+        flat += Clock::now() - t0;
+
+        game.atlas = atlas.image.get();
+        t0 = Clock::now();
+        image.fill(background);
+        game.draw();
+        sprites += Clock::now() - t0;
+    }
+
+    printf("%d frames of %dx%d\n", frames, scr_W, scr_H);
+    printf("load:    %8.4f ms for %dx%d %s\n", ms(loading) / loads, atlas.image->width, atlas.image->height, path);
+    printf("flat:    %8.4f ms/frame\n", ms(flat) / frames);
+    printf("sprites: %8.4f ms/frame\n", ms(sprites) / frames);
+    return 0;
+}
@@ -0,0 +1,356 @@
+//
+// Headless platform: no window, frames are presented into memory and input is scripted.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "../src/platform.h"
+
+// The run is configured through the environment:
+// - BRICKS_FRAMES: frames to run before the window closes, 600 by default.
+// - BRICKS_INPUT: events as <frame><+|-><key>, separated by spaces or commas, e.g. "1+d 2-d".
+//   Keys are a, d, s, w, space, escape, i, o, p, and mouse buttons L and R as L@x:y with x, y
+//   in window pixels from the top-left. Without it, the game is resumed at frame 1, then jumps
+//   left and right in turns every 30 frames and restarts after a game over.
+// - BRICKS_DUMP: path of a PPM file the last presented surface is written to at exit.
+
+struct LuGL::APPWINDOW
+{
+    byte_t      *surface;
+    int         width;
+    int         height;
+    int         stride;
+    bool        keys[KEY_NUM];
+    bool        buttons[BUTTON_NUM];
+    bool        should_close;
+    void        (*keyboardCallback)(AppWindow *window, KEY_CODE key, bool pressed);
+    void        (*mouseButtonCallback)(AppWindow *window, MOUSE_BUTTON button, bool pressed, float x, float y);
+    void        (*mouseScrollCallback)(AppWindow *window, float offset);
+    void        (*mouseDragCallback)(AppWindow *window, float x, float y);
+};
+
+// one scripted input change, applied by the pollEvent ending frame - 1
+struct InputEvent
+{
+    long    frame;
+    bool    pressed;
+    bool    mouse;
+    int     code;
+    float   x;
+    float   y;
+};
+
+LuGL::APPWINDOW *g_window = NULL;
+
+// what the window would show, packed pixels width x height
+std::vector<uint32_t>       g_display;
+std::vector<InputEvent>     g_events;
+size_t                      g_next_event = 0;
+long                        g_frames = 600;
+long                        g_frame = 0;
+long                        g_presents = 0;
+long long                   g_presented_pixels = 0;
+std::chrono::steady_clock::time_point g_start;
+
+static const char *g_key_names[LuGL::KEY_NUM] = { "a", "d", "s", "w", "space", "escape", "i", "o", "p" };
+
+static bool parseEvent(const char *text, InputEvent &event)
+{
+    char *end;
+    event.frame = strtol(text, &end, 10);
+    if (end == text || (*end != '+' && *end != '-')) return false;
+    event.pressed = *end++ == '+';
+    event.mouse = false;
+    event.x = event.y = 0.0f;
+
+    if (*end == 'L' || *end == 'R')
+    {
+        event.mouse = true;
+        event.code = *end == 'L' ? LuGL::BUTTON_L : LuGL::BUTTON_R;
+        return sscanf(end + 1, "@%f:%f", &event.x, &event.y) == 2;
+    }
+    for (int key = 0; key < LuGL::KEY_NUM; ++key)
+    {
+        if (strcmp(end, g_key_names[key]) == 0)
+        {
+            event.code = key;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void loadScript()
+{
+    if (const char *frames = getenv("BRICKS_FRAMES"))
+    {
+        g_frames = atol(frames);
+    }
+
+    const char *script = getenv("BRICKS_INPUT");
+    if (!script)
+    {
+        // resume, then tap A and D in turns, and click where Restart shows after a game over
+        g_events.push_back({ 1, true, false, LuGL::KEY_D, 0.0f, 0.0f });
+        g_events.push_back({ 2, false, false, LuGL::KEY_D, 0.0f, 0.0f });
+        for (long frame = 30; frame < g_frames; frame += 30)
+        {
+            int key = (frame / 30) % 2 ? LuGL::KEY_A : LuGL::KEY_D;
+            g_events.push_back({ frame, true, false, key, 0.0f, 0.0f });
+            g_events.push_back({ frame + 1, false, false, key, 0.0f, 0.0f });
+            g_events.push_back({ frame + 15, true, true, LuGL::BUTTON_L, 50.0f, 175.0f });
+            g_events.push_back({ frame + 16, false, true, LuGL::BUTTON_L, 50.0f, 175.0f });
+        }
+        return;
+    }
+
+    std::vector<char> token;
+    for (const char *c = script; ; ++c)
+    {
+        if (*c && !isspace((unsigned char)*c) && *c != ',')
+        {
+            token.push_back(*c);
+            continue;
+        }
+        if (!token.empty())
+        {
+            token.push_back('\0');
+            InputEvent event;
+            if (parseEvent(token.data(), event)) g_events.push_back(event);
+            else fprintf(stderr, "BRICKS_INPUT: ignoring \"%s\"\n", token.data());
+            token.clear();
+        }
+        if (!*c) break;
+    }
+    // stable, so events of one frame keep their order
+    std::stable_sort(g_events.begin(), g_events.end(), [](const InputEvent &a, const InputEvent &b)
+    {
+        return a.frame < b.frame;
+    });
+}
+
+static void applyEvent(const InputEvent &event)
+{
+    if (event.mouse)
+    {
+        LuGL::MOUSE_BUTTON button = (LuGL::MOUSE_BUTTON)event.code;
+        g_window->buttons[button] = event.pressed;
+        if (g_window->mouseButtonCallback)
+        {
+            // inverse Y, as the window backends do
+            g_window->mouseButtonCallback(g_window, button, event.pressed, event.x, g_window->height - event.y);
+        }
+        return;
+    }
+
+    LuGL::KEY_CODE key = (LuGL::KEY_CODE)event.code;
+    g_window->keys[key] = event.pressed;
+    if (g_window->keyboardCallback)
+    {
+        g_window->keyboardCallback(g_window, key, event.pressed);
+    }
+}
+
+static void present(int x, int y, int width, int height)
+{
+    // clip, as a window would
+    if (x < 0) { width += x; x = 0; }
+    if (y < 0) { height += y; y = 0; }
+    if (x + width > g_window->width) width = g_window->width - x;
+    if (y + height > g_window->height) height = g_window->height - y;
+    if (width <= 0 || height <= 0) return;
+
+    const uint32_t *surface = (const uint32_t*)g_window->surface;
+    for (int row = y; row < y + height; ++row)
+    {
+        memcpy(&g_display[(size_t)row * g_window->width + x], surface + (size_t)row * g_window->stride + x, width * sizeof(uint32_t));
+    }
+    g_presented_pixels += (long long)width * height;
+}
+
+static void dumpDisplay(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "BRICKS_DUMP: cannot write %s\n", path);
+        return;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", g_window->width, g_window->height);
+    std::vector<unsigned char> row(g_window->width * 3);
+    for (int y = 0; y < g_window->height; ++y)
+    {
+        // surface pixels are R, G, B, A in memory
+        const unsigned char *src = (const unsigned char*)&g_display[(size_t)y * g_window->width];
+        for (int x = 0; x < g_window->width; ++x)
+        {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        fwrite(row.data(), 1, row.size(), file);
+    }
+    fclose(file);
+}
+
+void LuGL::initializeApplication()
+{
+    loadScript();
+}
+
+// need no implementation
+void LuGL::runApplication() {};
+
+void LuGL::terminateApplication()
+{
+    if (!g_window) return;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - g_start).count();
+    printf("Headless: %ld frames in %.3f s, %.1f fps, %ld presents, %.1f pixels presented per frame\n",
+        g_frame, seconds, seconds > 0.0 ? g_frame / seconds : 0.0, g_presents,
+        g_frame ? (double)g_presented_pixels / g_frame : 0.0);
+    if (const char *path = getenv("BRICKS_DUMP"))
+    {
+        dumpDisplay(path);
+    }
+    delete g_window;
+    g_window = NULL;
+}
+
+LuGL::PIXEL_FORMAT LuGL::getSurfaceFormat()
+{
+    return PIXEL_RGBA;
+}
+
+// nothing shows a title
+void LuGL::setWindowTitle(AppWindow *window, const char *title)
+{
+    __unused_variable(window);
+    __unused_variable(title);
+}
+
+LuGL::AppWindow* LuGL::createWindow(const char *title, long width, long height, byte_t *surface_buffer, long surface_stride)
+{
+    __unused_variable(title);
+    g_window = new LuGL::AppWindow();
+    g_window->surface = surface_buffer;
+    g_window->width = width;
+    g_window->height = height;
+    g_window->stride = surface_stride > 0 ? surface_stride : width;
+    g_display.assign((size_t)width * height, 0);
+    g_start = std::chrono::steady_clock::now();
+    return g_window;
+}
+
+void LuGL::destroyWindow(AppWindow *window)
+{
+    window->should_close = true;
+}
+
+void LuGL::swapBuffer(AppWindow *window)
+{
+    ++g_presents;
+    present(0, 0, window->width, window->height);
+}
+
+void LuGL::swapBufferRegions(AppWindow *window, const Region *regions, int count)
+{
+    __unused_variable(window);
+    ++g_presents;
+    for (int i = 0; i < count; ++i)
+    {
+        present(regions[i].x, regions[i].y, regions[i].width, regions[i].height);
+    }
+}
+
+bool LuGL::windowShouldClose(AppWindow *window)
+{
+    return window->should_close;
+}
+
+// presents and scripted events touch nothing in common
+bool LuGL::canPresentFromThread()
+{
+    return true;
+}
+
+// only presents read the surface
+std::mutex &LuGL::surfaceLock(AppWindow *window)
+{
+    __unused_variable(window);
+    static std::mutex lock;
+    return lock;
+}
+
+// ends a frame, there is no vsync or event wait, so frames run as fast as they are drawn
+void LuGL::pollEvent()
+{
+    if (!g_window) return;
+    ++g_frame;
+    while (g_next_event < g_events.size() && g_events[g_next_event].frame <= g_frame)
+    {
+        applyEvent(g_events[g_next_event++]);
+    }
+    if (g_frame >= g_frames)
+    {
+        g_window->should_close = true;
+    }
+}
+
+/**
+ * input & callback registrations
+ */
+void LuGL::setKeyboardCallback(AppWindow *window, void(*callback)(AppWindow*, KEY_CODE, bool))
+{
+    window->keyboardCallback = callback;
+}
+
+void LuGL::setMouseButtonCallback(AppWindow *window, void(*callback)(AppWindow*, MOUSE_BUTTON, bool, float, float))
+{
+    window->mouseButtonCallback = callback;
+}
+
+void LuGL::setMouseScrollCallback(AppWindow *window, void(*callback)(AppWindow*, float))
+{
+    window->mouseScrollCallback = callback;
+}
+
+void LuGL::setMouseDragCallback(AppWindow *window, void(*callback)(AppWindow*, float, float))
+{
+    window->mouseDragCallback = callback;
+}
+
+bool LuGL::isKeyDown(AppWindow *window, KEY_CODE key)
+{
+    return window->keys[key];
+}
+
+bool LuGL::isMouseButtonDown(AppWindow *window, MOUSE_BUTTON button)
+{
+    return window->buttons[button];
+}
+
+LuGL::Time LuGL::getSystemTime()
+{
+    auto now = std::chrono::system_clock::now();
+    time_t seconds = std::chrono::system_clock::to_time_t(now);
+    struct tm local = *localtime(&seconds);
+
+    LuGL::Time time;
+    time.year = local.tm_year + 1900;
+    time.month = local.tm_mon + 1;
+    time.day_of_week = local.tm_wday;
+    time.day = local.tm_mday;
+    time.hour = local.tm_hour;
+    time.minute = local.tm_min;
+    time.second = local.tm_sec;
+    time.millisecond = (int)(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+
+    return time;
+}
@@ -22,6 +22,7 @@ struct LuGL::APPWINDOW
     byte_t      *surface;
     int         width;
     int         height;
+    int         stride;
     bool        keys[KEY_NUM];
     bool        buttons[BUTTON_NUM];
     bool        should_close;
@@ -96,6 +97,23 @@ void LuGL::swapBuffer(AppWindow *window)
     [[window->handle contentView] setNeedsDisplay:YES];  // invoke drawRect
 }
 
+void LuGL::swapBufferRegions(AppWindow *window, const Region *regions, int count)
+{
+    NSView *view = [window->handle contentView];
+    NSRect bounds = [view bounds];
+    CGFloat sx = bounds.size.width / window->width;
+    CGFloat sy = bounds.size.height / window->height;
+    for (int i = 0; i < count; ++i)
+    {
+        // view origin is at the bottom-left corner
+        NSRect rect = NSMakeRect(regions[i].x * sx,
+                                 (window->height - regions[i].y - regions[i].height) * sy,
+                                 regions[i].width * sx,
+                                 regions[i].height * sy);
+        [view setNeedsDisplayInRect:rect];  // invoke drawRect with the union of rects
+    }
+}
+
 // virtual-key codes reference : https://stackoverflow.com/questions/3202629/where-can-i-find-a-list-of-mac-virtual-key-codes
 void handleKeyEvent(AppWindow *window, long virtual_key, bool pressed)
 {
@@ -243,18 +261,27 @@ void handleMouseScroll(AppWindow *window, float delta)
                             hasAlpha:NO
                             isPlanar:NO
                       colorSpaceName:NSCalibratedRGBColorSpace
-                         bytesPerRow:_window->width * 3
-                        bitsPerPixel:24] autorelease];
-    NSImage *nsimage = [[[NSImage alloc] init] autorelease];
+                         bytesPerRow:_window->stride * 4
+                        bitsPerPixel:32] autorelease];
+    NSImage *nsimage = [[[NSImage alloc] initWithSize:NSMakeSize(_window->width, _window->height)] autorelease];
     [nsimage addRepresentation:rep];
-    [nsimage drawInRect:dirtyRect];
+    // map the dirty part of the view back onto the surface, which is stretched over the whole view
+    NSRect bounds = [self bounds];
+    CGFloat sx = _window->width / bounds.size.width;
+    CGFloat sy = _window->height / bounds.size.height;
+    NSRect fromRect = NSMakeRect(dirtyRect.origin.x * sx, dirtyRect.origin.y * sy,
+                                 dirtyRect.size.width * sx, dirtyRect.size.height * sy);
+    [nsimage drawInRect:dirtyRect
+               fromRect:fromRect
+              operation:NSCompositingOperationCopy
+               fraction:1.0];
 }
 
 @end
 
 ContentView *g_view;
 
-AppWindow* LuGL::createWindow(const char *title, long width, long height, unsigned char *surface_buffer)
+AppWindow* LuGL::createWindow(const char *title, long width, long height, unsigned char *surface_buffer, long surface_stride)
 {
     NSUInteger windowStyle = NSWindowStyleMaskTitled | NSWindowStyleMaskClosable | NSWindowStyleMaskResizable;
 
@@ -271,6 +298,7 @@ AppWindow* LuGL::createWindow(const char *title, long width, long height, unsign
     window->surface = surface_buffer;
     window->width = width;
     window->height = height;
+    window->stride = surface_stride > 0 ? surface_stride : width;
 
     WindowDelegate *delegate;
     delegate = [[WindowDelegate alloc] initWithWindow:window];
@@ -289,6 +317,12 @@ AppWindow* LuGL::createWindow(const char *title, long width, long height, unsign
     return window;
 }
 
+PIXEL_FORMAT LuGL::getSurfaceFormat()
+{
+    // RGB samples padded to 32 bits, alpha byte is ignored
+    return PIXEL_RGBA;
+}
+
 void LuGL::setWindowTitle(AppWindow *window, const char *title)
 {
     [window->handle setTitle:[NSString stringWithUTF8String:title]];
@@ -334,6 +368,20 @@ bool LuGL::windowShouldClose(AppWindow *window)
     return window->should_close;
 }
 
+// AppKit views are only drawn on the main thread
+bool LuGL::canPresentFromThread()
+{
+    return false;
+}
+
+// the surface is only written and read on the thread polling events
+std::mutex &LuGL::surfaceLock(AppWindow *window)
+{
+    __unused_variable(window);
+    static std::mutex lock;
+    return lock;
+}
+
 /**
  * input & callback registrations
  */
@@ -29,12 +29,13 @@ struct LuGL::APPWINDOW
 };
 
 LuGL::APPWINDOW * g_window;
-LuGL::byte_t * g_paint_surface;
 
 HINSTANCE   g_hInstance;
 POINTS      g_mouse_pts;
 BITMAPINFO  g_bitmapinfo;
 bool        g_update_paint = false;
+// accumulated swapBufferRegions since the last paint, NULL repaints the whole surface
+HRGN        g_paint_region = NULL;
 
 static void handleKeyPress(WPARAM wParam, bool pressed)
 {
@@ -90,17 +91,6 @@ static void handleMouseScroll(float delta)
     }
 }
 
-static void blitRGB2BGR(const LuGL::byte_t * src, LuGL::byte_t * tar, const size_t & width, const size_t & height)
-{
-    size_t image_size = width * height * 3;
-    for (size_t i = 0; i < image_size; i += 3)
-    {
-        tar[i] = src[i + 2];
-        tar[i + 1] = src[i + 1];
-        tar[i + 2] = src[i];
-    }
-}
-
 // handling windows procedures
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
@@ -111,21 +101,30 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
     if (g_update_paint)
     {
         HDC hdc = GetDC(hwnd);
+        // clip to the regions passed to swapBufferRegions, GDI then only uploads those pixels
+        if (g_paint_region)
+        {
+            SelectClipRgn(hdc, g_paint_region);
+        }
 
-        blitRGB2BGR(g_window->surface, g_paint_surface, g_window->width, g_window->height);
         SetDIBitsToDevice(
             hdc,
             0, 0,
             g_window->width,
             g_window->height,
             0, 0, 0, g_window->height,
-            (void*)(g_paint_surface),
+            (void*)(g_window->surface),
             &g_bitmapinfo,
             DIB_RGB_COLORS
         );
 
         ReleaseDC(hwnd, hdc);
         g_update_paint = false;
+        if (g_paint_region)
+        {
+            DeleteObject(g_paint_region);
+            g_paint_region = NULL;
+        }
     }
 
     switch(msg)
@@ -170,14 +169,13 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
             {
                 HDC hdc = GetDC(hwnd);
 
-                blitRGB2BGR(g_window->surface, g_paint_surface, g_window->width, g_window->height);
                 SetDIBitsToDevice(
                     hdc,
                     0, 0,
                     g_window->width,
                     g_window->height,
                     0, 0, 0, g_window->height,
-                    (void*)(g_paint_surface),
+                    (void*)(g_window->surface),
                     &g_bitmapinfo,
                     DIB_RGB_COLORS
                 );
@@ -227,10 +225,13 @@ void LuGL::initializeApplication()
 // need no implementation
 void LuGL::runApplication() {};
 
-void LuGL::terminateApplication()
+// need no implementation
+void LuGL::terminateApplication() {};
+
+LuGL::PIXEL_FORMAT LuGL::getSurfaceFormat()
 {
-    delete[] g_paint_surface;
-};
+    return PIXEL_BGRX;
+}
 
 void LuGL::setWindowTitle(AppWindow *window, const char *title)
 {
@@ -238,7 +239,7 @@ void LuGL::setWindowTitle(AppWindow *window, const char *title)
 }
 
 
-LuGL::AppWindow* LuGL::createWindow(const char *title, long width, long height, byte_t *surface_buffer)
+LuGL::AppWindow* LuGL::createWindow(const char *title, long width, long height, byte_t *surface_buffer, long surface_stride)
 {
     HWND hwnd = CreateWindowEx(
         0,
@@ -266,8 +267,10 @@ LuGL::AppWindow* LuGL::createWindow(const char *title, long width, long height,
     MoveWindow(hwnd, winRect.left, winRect.top, width + wDiff, height + hDiff, TRUE);
 
     g_bitmapinfo.bmiHeader.biSize           = sizeof(BITMAPINFOHEADER);
-    g_bitmapinfo.bmiHeader.biBitCount       = 24;
-    g_bitmapinfo.bmiHeader.biWidth          = width;
+    // surface is presented as is, 32-bit DIB pixels are B, G, R, X in memory
+    // padded rows are a wider DIB, only the first width columns are blitted
+    g_bitmapinfo.bmiHeader.biBitCount       = 32;
+    g_bitmapinfo.bmiHeader.biWidth          = surface_stride > 0 ? surface_stride : width;
     g_bitmapinfo.bmiHeader.biHeight         = -height;
     g_bitmapinfo.bmiHeader.biCompression    = BI_RGB;
     g_bitmapinfo.bmiHeader.biClrUsed        = 0;
@@ -280,8 +283,6 @@ LuGL::AppWindow* LuGL::createWindow(const char *title, long width, long height,
     g_window->surface = surface_buffer;
     g_window->width = width;
     g_window->height = height;
-    g_paint_surface = new LuGL::byte_t[width * height * 3];
-    memset(g_paint_surface, 0, sizeof(LuGL::byte_t) * width * height * 3);
 
     ShowWindow(hwnd, SW_SHOWNORMAL);
     UpdateWindow(hwnd);
@@ -297,6 +298,33 @@ void LuGL::destroyWindow(AppWindow *window)
 void LuGL::swapBuffer(AppWindow *window)
 {
     __unused_variable(window);
+    if (g_paint_region)
+    {
+        DeleteObject(g_paint_region);
+        g_paint_region = NULL;
+    }
+    g_update_paint = true;
+}
+
+void LuGL::swapBufferRegions(AppWindow *window, const Region *regions, int count)
+{
+    __unused_variable(window);
+    // a pending full repaint already covers the regions
+    if (g_update_paint && !g_paint_region) return;
+    if (!g_paint_region)
+    {
+        g_paint_region = CreateRectRgn(0, 0, 0, 0);
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        HRGN rect = CreateRectRgn(
+            regions[i].x,
+            regions[i].y,
+            regions[i].x + regions[i].width,
+            regions[i].y + regions[i].height);
+        CombineRgn(g_paint_region, g_paint_region, rect, RGN_OR);
+        DeleteObject(rect);
+    }
     g_update_paint = true;
 }
 
@@ -305,6 +333,20 @@ bool LuGL::windowShouldClose(AppWindow *window)
     return window->should_close;
 }
 
+// the surface is blitted by WM_PAINT, on the thread polling events
+bool LuGL::canPresentFromThread()
+{
+    return false;
+}
+
+// the surface is only written and read on the thread polling events
+std::mutex &LuGL::surfaceLock(AppWindow *window)
+{
+    __unused_variable(window);
+    static std::mutex lock;
+    return lock;
+}
+
 void LuGL::pollEvent()
 {
     static MSG msg;
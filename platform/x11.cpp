@@ -0,0 +1,488 @@
+//
+// Linux window on Xlib, frames are presented through MIT-SHM when the server supports it.
+//
+
+#if defined(__linux__) || defined(__unix__)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XShm.h>
+#include "../src/platform.h"
+
+// BRICKS_X11_SHM=0 presents with plain XPutImage, to compare present cost against MIT-SHM.
+// At exit the average time spent presenting a frame is printed for either path.
+
+struct LuGL::APPWINDOW
+{
+    Window      handle;
+    GC          gc;
+    byte_t      *surface;
+    int         width;
+    int         height;
+    int         stride;
+    bool        keys[KEY_NUM];
+    bool        buttons[BUTTON_NUM];
+    bool        should_close;
+    void        (*keyboardCallback)(AppWindow *window, KEY_CODE key, bool pressed);
+    void        (*mouseButtonCallback)(AppWindow *window, MOUSE_BUTTON button, bool pressed, float x, float y);
+    void        (*mouseScrollCallback)(AppWindow *window, float offset);
+    void        (*mouseDragCallback)(AppWindow *window, float x, float y);
+
+    // XPutImage path: wraps surface itself, XPutImage sends its pixels through the socket
+    XImage      *image;
+    // MIT-SHM path: a shared segment the server reads from, regions are copied into it first
+    XImage      *shm_image;
+    XShmSegmentInfo shm_info;
+    // an XShmPutImage the server has not finished reading from
+    std::atomic<bool> shm_pending;
+};
+
+LuGL::APPWINDOW *g_window = NULL;
+
+Display     *g_display = NULL;
+Atom        g_wm_delete_window;
+int         g_shm_completion = -1;
+bool        g_shm_failed = false;
+// presents may come from another thread than pollEvent, and from Expose events
+// it is also the surface lock, the Expose redraw reads the surface
+std::mutex  g_present_lock;
+long        g_presents = 0;
+double      g_present_seconds = 0.0;
+
+static int handleShmError(Display *display, XErrorEvent *event)
+{
+    __unused_variable(display);
+    __unused_variable(event);
+    g_shm_failed = true;
+    return 0;
+}
+
+// reference : https://www.x.org/releases/X11R7.7/doc/xextproto/shm.html
+static bool createShmImage(LuGL::AppWindow *window, Visual *visual, int depth)
+{
+    const char *shm = getenv("BRICKS_X11_SHM");
+    if ((shm && strcmp(shm, "0") == 0) || !XShmQueryExtension(g_display))
+    {
+        return false;
+    }
+
+    XShmSegmentInfo &info = window->shm_info;
+    window->shm_image = XShmCreateImage(g_display, visual, depth, ZPixmap, NULL, &info, window->width, window->height);
+    if (!window->shm_image)
+    {
+        return false;
+    }
+    info.shmid = shmget(IPC_PRIVATE, (size_t)window->shm_image->bytes_per_line * window->height, IPC_CREAT | 0600);
+    if (info.shmid < 0)
+    {
+        XDestroyImage(window->shm_image);
+        window->shm_image = NULL;
+        return false;
+    }
+    info.shmaddr = window->shm_image->data = (char*)shmat(info.shmid, NULL, 0);
+    info.readOnly = True;
+
+    // attaching fails on remote displays, which only show up as an asynchronous error
+    g_shm_failed = info.shmaddr == (char*)-1;
+    if (!g_shm_failed)
+    {
+        int (*previous)(Display*, XErrorEvent*) = XSetErrorHandler(handleShmError);
+        XShmAttach(g_display, &info);
+        XSync(g_display, False);
+        XSetErrorHandler(previous);
+    }
+    // the segment is freed once both sides detach
+    shmctl(info.shmid, IPC_RMID, NULL);
+    if (g_shm_failed)
+    {
+        if (info.shmaddr != (char*)-1) shmdt(info.shmaddr);
+        window->shm_image->data = NULL;
+        XDestroyImage(window->shm_image);
+        window->shm_image = NULL;
+        return false;
+    }
+    g_shm_completion = XShmGetEventBase(g_display) + ShmCompletion;
+    return true;
+}
+
+static void destroyShmImage(LuGL::AppWindow *window)
+{
+    if (!window->shm_image) return;
+    XShmDetach(g_display, &window->shm_info);
+    shmdt(window->shm_info.shmaddr);
+    window->shm_image->data = NULL;
+    XDestroyImage(window->shm_image);
+    window->shm_image = NULL;
+}
+
+// the shared segment must not change while the server still reads it
+// only the completion is taken from the queue, the rest is left to pollEvent, maybe on another thread
+static void waitShmCompletion()
+{
+    while (g_window->shm_pending)
+    {
+        XEvent event;
+        if (XCheckTypedEvent(g_display, g_shm_completion, &event))
+        {
+            g_window->shm_pending = false;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+static void present(LuGL::AppWindow *window, const LuGL::Region *regions, int count)
+{
+    std::lock_guard<std::mutex> lock(g_present_lock);
+    auto start = std::chrono::steady_clock::now();
+    if (window->shm_image)
+    {
+        waitShmCompletion();
+        for (int i = 0; i < count; ++i)
+        {
+            const LuGL::Region &r = regions[i];
+            for (int y = r.y; y < r.y + r.height; ++y)
+            {
+                memcpy(window->shm_image->data + (size_t)y * window->shm_image->bytes_per_line + r.x * 4,
+                       window->surface + ((size_t)y * window->stride + r.x) * 4,
+                       r.width * 4);
+            }
+        }
+        // set before the requests go out, pollEvent may flush them and take the completion right away,
+        // only the completion event clears it
+        window->shm_pending = count > 0;
+        for (int i = 0; i < count; ++i)
+        {
+            const LuGL::Region &r = regions[i];
+            // only the last request asks for a completion event, the server handles them in order
+            XShmPutImage(g_display, window->handle, window->gc, window->shm_image,
+                         r.x, r.y, r.x, r.y, r.width, r.height, i == count - 1);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            const LuGL::Region &r = regions[i];
+            XPutImage(g_display, window->handle, window->gc, window->image,
+                      r.x, r.y, r.x, r.y, r.width, r.height);
+        }
+    }
+    XFlush(g_display);
+    g_present_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ++g_presents;
+}
+
+static void handleKey(XKeyEvent &event, bool pressed)
+{
+    LuGL::KEY_CODE key;
+    // reference : /usr/include/X11/keysymdef.h
+    switch (XLookupKeysym(&event, 0))
+    {
+        case XK_a:      key = LuGL::KEY_A;      break;
+        case XK_d:      key = LuGL::KEY_D;      break;
+        case XK_s:      key = LuGL::KEY_S;      break;
+        case XK_w:      key = LuGL::KEY_W;      break;
+        case XK_space:  key = LuGL::KEY_SPACE;  break;
+        case XK_Escape: key = LuGL::KEY_ESCAPE; break;
+        case XK_i:      key = LuGL::KEY_I;      break;
+        case XK_o:      key = LuGL::KEY_O;      break;
+        case XK_p:      key = LuGL::KEY_P;      break;
+        default:        key = LuGL::KEY_NUM;    break;
+    }
+
+    if (key < LuGL::KEY_NUM)
+    {
+        g_window->keys[key] = pressed;
+        if (g_window->keyboardCallback)
+        {
+            g_window->keyboardCallback(g_window, key, pressed);
+        }
+    }
+}
+
+static void handleButton(XButtonEvent &event, bool pressed)
+{
+    // buttons 4 and 5 are the wheel, a press per step
+    if (event.button == Button4 || event.button == Button5)
+    {
+        if (pressed && g_window->mouseScrollCallback)
+        {
+            g_window->mouseScrollCallback(g_window, event.button == Button4 ? 1.0f : -1.0f);
+        }
+        return;
+    }
+
+    LuGL::MOUSE_BUTTON button;
+    if (event.button == Button1)      button = LuGL::BUTTON_L;
+    else if (event.button == Button3) button = LuGL::BUTTON_R;
+    else return;
+
+    g_window->buttons[button] = pressed;
+    if (g_window->mouseButtonCallback)
+    {
+        // inverse Y
+        g_window->mouseButtonCallback(g_window, button, pressed, event.x, g_window->height - event.y);
+    }
+}
+
+static void handleEvent(XEvent &event)
+{
+    if (event.type == g_shm_completion)
+    {
+        g_window->shm_pending = false;
+        return;
+    }
+
+    switch (event.type)
+    {
+        case KeyPress:
+            handleKey(event.xkey, true);
+            break;
+        case KeyRelease:
+            // auto-repeat sends a release right before a press at the same time, skip both
+            if (XEventsQueued(g_display, QueuedAfterReading))
+            {
+                XEvent next;
+                XPeekEvent(g_display, &next);
+                if (next.type == KeyPress && next.xkey.time == event.xkey.time && next.xkey.keycode == event.xkey.keycode)
+                {
+                    XNextEvent(g_display, &next);
+                    break;
+                }
+            }
+            handleKey(event.xkey, false);
+            break;
+        case ButtonPress:
+            handleButton(event.xbutton, true);
+            break;
+        case ButtonRelease:
+            handleButton(event.xbutton, false);
+            break;
+        case MotionNotify:
+            // left mouse drag
+            if ((event.xmotion.state & Button1Mask) && g_window->mouseDragCallback)
+            {
+                g_window->mouseDragCallback(g_window, event.xmotion.x, g_window->height - event.xmotion.y);
+            }
+            break;
+        case Expose:
+            if (event.xexpose.count == 0)
+            {
+                LuGL::Region all = { 0, 0, g_window->width, g_window->height };
+                present(g_window, &all, 1);
+            }
+            break;
+        case ClientMessage:
+            if ((Atom)event.xclient.data.l[0] == g_wm_delete_window)
+            {
+                g_window->should_close = true;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void LuGL::initializeApplication()
+{
+    // before any other Xlib call, so frames can be presented from their own thread
+    XInitThreads();
+    g_display = XOpenDisplay(NULL);
+    if (!g_display)
+    {
+        fprintf(stderr, "Cannot open X display %s\n", XDisplayName(NULL));
+        exit(1);
+    }
+    g_wm_delete_window = XInternAtom(g_display, "WM_DELETE_WINDOW", False);
+}
+
+// need no implementation
+void LuGL::runApplication() {};
+
+void LuGL::terminateApplication()
+{
+    if (!g_display) return;
+    if (g_window)
+    {
+        if (g_presents)
+        {
+            printf("X11: %ld presents with %s, %.3f ms per present\n", g_presents,
+                g_window->shm_image ? "MIT-SHM" : "XPutImage", g_present_seconds * 1000.0 / g_presents);
+        }
+        waitShmCompletion();
+        destroyShmImage(g_window);
+        // surface belongs to the caller
+        g_window->image->data = NULL;
+        XDestroyImage(g_window->image);
+        XFreeGC(g_display, g_window->gc);
+        XDestroyWindow(g_display, g_window->handle);
+        delete g_window;
+        g_window = NULL;
+    }
+    XCloseDisplay(g_display);
+    g_display = NULL;
+}
+
+LuGL::PIXEL_FORMAT LuGL::getSurfaceFormat()
+{
+    // 24-bit TrueColor on a little-endian host is B, G, R, X in memory
+    Visual *visual = DefaultVisual(g_display, DefaultScreen(g_display));
+    return visual->red_mask == 0xFF ? PIXEL_RGBA : PIXEL_BGRX;
+}
+
+void LuGL::setWindowTitle(AppWindow *window, const char *title)
+{
+    XStoreName(g_display, window->handle, title);
+}
+
+LuGL::AppWindow* LuGL::createWindow(const char *title, long width, long height, byte_t *surface_buffer, long surface_stride)
+{
+    int screen = DefaultScreen(g_display);
+    Visual *visual = DefaultVisual(g_display, screen);
+    int depth = DefaultDepth(g_display, screen);
+    if (depth != 24 && depth != 32)
+    {
+        fprintf(stderr, "X11: a 24 or 32-bit TrueColor visual is needed, the default one is %d-bit\n", depth);
+        return 0;
+    }
+
+    Window handle = XCreateSimpleWindow(g_display, RootWindow(g_display, screen),
+        0, 0, width, height, 0, BlackPixel(g_display, screen), BlackPixel(g_display, screen));
+    XSelectInput(g_display, handle,
+        ExposureMask | KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask | Button1MotionMask);
+    XSetWMProtocols(g_display, handle, &g_wm_delete_window, 1);
+
+    // fixed size, the surface is not scaled
+    XSizeHints *hints = XAllocSizeHints();
+    hints->flags = PMinSize | PMaxSize;
+    hints->min_width = hints->max_width = width;
+    hints->min_height = hints->max_height = height;
+    XSetWMNormalHints(g_display, handle, hints);
+    XFree(hints);
+
+    g_window = new LuGL::AppWindow();
+    g_window->handle = handle;
+    g_window->gc = XCreateGC(g_display, handle, 0, NULL);
+    g_window->surface = surface_buffer;
+    g_window->width = width;
+    g_window->height = height;
+    g_window->stride = surface_stride > 0 ? surface_stride : width;
+    // padded rows are a wider image, only the first width columns are put
+    g_window->image = XCreateImage(g_display, visual, depth, ZPixmap, 0, (char*)surface_buffer,
+        width, height, 32, g_window->stride * 4);
+    createShmImage(g_window, visual, depth);
+
+    XStoreName(g_display, handle, title);
+    XMapWindow(g_display, handle);
+    XFlush(g_display);
+
+    return g_window;
+}
+
+void LuGL::destroyWindow(AppWindow *window)
+{
+    window->should_close = true;
+}
+
+void LuGL::swapBuffer(AppWindow *window)
+{
+    LuGL::Region all = { 0, 0, window->width, window->height };
+    present(window, &all, 1);
+}
+
+void LuGL::swapBufferRegions(AppWindow *window, const Region *regions, int count)
+{
+    present(window, regions, count);
+}
+
+bool LuGL::windowShouldClose(AppWindow *window)
+{
+    return window->should_close;
+}
+
+// Xlib locks the display itself after XInitThreads, presents are serialized by g_present_lock
+bool LuGL::canPresentFromThread()
+{
+    return true;
+}
+
+std::mutex &LuGL::surfaceLock(AppWindow *window)
+{
+    __unused_variable(window);
+    return g_present_lock;
+}
+
+void LuGL::pollEvent()
+{
+    while (XPending(g_display))
+    {
+        XEvent event;
+        XNextEvent(g_display, &event);
+        handleEvent(event);
+    }
+}
+
+/**
+ * input & callback registrations
+ */
+void LuGL::setKeyboardCallback(AppWindow *window, void(*callback)(AppWindow*, KEY_CODE, bool))
+{
+    window->keyboardCallback = callback;
+}
+
+void LuGL::setMouseButtonCallback(AppWindow *window, void(*callback)(AppWindow*, MOUSE_BUTTON, bool, float, float))
+{
+    window->mouseButtonCallback = callback;
+}
+
+void LuGL::setMouseScrollCallback(AppWindow *window, void(*callback)(AppWindow*, float))
+{
+    window->mouseScrollCallback = callback;
+}
+
+void LuGL::setMouseDragCallback(AppWindow *window, void(*callback)(AppWindow*, float, float))
+{
+    window->mouseDragCallback = callback;
+}
+
+bool LuGL::isKeyDown(AppWindow *window, KEY_CODE key)
+{
+    return window->keys[key];
+}
+
+bool LuGL::isMouseButtonDown(AppWindow *window, MOUSE_BUTTON button)
+{
+    return window->buttons[button];
+}
+
+LuGL::Time LuGL::getSystemTime()
+{
+    auto now = std::chrono::system_clock::now();
+    time_t seconds = std::chrono::system_clock::to_time_t(now);
+    struct tm local = *localtime(&seconds);
+
+    LuGL::Time time;
+    time.year = local.tm_year + 1900;
+    time.month = local.tm_mon + 1;
+    time.day_of_week = local.tm_wday;
+    time.day = local.tm_mday;
+    time.hour = local.tm_hour;
+    time.minute = local.tm_min;
+    time.second = local.tm_sec;
+    time.millisecond = (int)(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+
+    return time;
+}
+#endif
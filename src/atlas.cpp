@@ -0,0 +1,171 @@
+#include "atlas.h"
+#include <cstring>
+#include "span.h"
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only mapping of a whole file, unmapped when it goes out of scope.
+struct MappedFile {
+    uint8_t const* data = nullptr;
+    size_t size = 0;
+
+    explicit MappedFile(char const* path);
+    ~MappedFile();
+    MappedFile(MappedFile const&) = delete;
+    MappedFile & operator=(MappedFile const&) = delete;
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+#ifdef _WIN32
+MappedFile::MappedFile(char const* path) {
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return;
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(file, &length) || length.QuadPart == 0) return;
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) return;
+    data = static_cast<uint8_t const*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data) size = (size_t)length.QuadPart;
+}
+
+MappedFile::~MappedFile() {
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+}
+#else
+MappedFile::MappedFile(char const* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            data = static_cast<uint8_t const*>(p);
+            size = (size_t)st.st_size;
+        }
+    }
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data) munmap(const_cast<uint8_t *>(data), size);
+}
+#endif
+
+// Parse one ASCII header number of a PPM, skipping whitespace and comments.
+static bool ppmNumber(MappedFile const& file, size_t & at, int & value) {
+    while (at < file.size) {
+        char c = (char)file.data[at];
+        if (c == '#') {
+            while (at < file.size && file.data[at] != '\n') ++at;
+        }
+        else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            ++at;
+        }
+        else {
+            break;
+        }
+    }
+    if (at >= file.size || file.data[at] < '0' || file.data[at] > '9') return false;
+    value = 0;
+    while (at < file.size && file.data[at] >= '0' && file.data[at] <= '9') {
+        value = value * 10 + (file.data[at++] - '0');
+        if (value > 1 << 16) return false;
+    }
+    return true;
+}
+
+static uint32_t readLE(uint8_t const* p, int bytes) {
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) value = (value << 8) | p[i];
+    return value;
+}
+
+// Pixels equal to key become 0, so they are skipped when drawn.
+static void applyKey(uint32_t *row, int count, uint32_t key) {
+    for (int x = 0; x < count; ++x) {
+        if (row[x] == key) row[x] = 0;
+    }
+}
+
+bool SpriteAtlas::load(char const* path, PixelFormat format, color8 const& key) {
+    image.reset();
+    MappedFile file(path);
+    if (!file.data) return false;
+
+    bool bgrx = format == PixelFormat::BGRX;
+    // Packed pixels are opaque, the key is compared with alpha or padding set.
+    color8 opaqueKey = key;
+    opaqueKey.a = 255;
+
+    if (file.size > 2 && file.data[0] == 'P' && file.data[1] == '6') {
+        size_t at = 2;
+        int w, h, maxValue;
+        if (!ppmNumber(file, at, w) || !ppmNumber(file, at, h) || !ppmNumber(file, at, maxValue)) return false;
+        // A single whitespace byte ends the header.
+        ++at;
+        if (maxValue != 255 || w <= 0 || h <= 0 || at + (size_t)w * h * 3 > file.size) return false;
+
+        image.reset(new Image(w, h, format));
+        uint32_t packedKey = image->pack(opaqueKey);
+        for (int y = 0; y < h; ++y) {
+            auto *row = image->data + (size_t)y * image->stride;
+            swizzleRGBSpan(row, file.data + at + (size_t)y * w * 3, w, bgrx);
+            applyKey(row, w, packedKey);
+        }
+        return true;
+    }
+
+    if (file.size > 54 && file.data[0] == 'B' && file.data[1] == 'M') {
+        uint32_t offset = readLE(file.data + 10, 4);
+        int w = (int32_t)readLE(file.data + 18, 4);
+        int h = (int32_t)readLE(file.data + 22, 4);
+        int bits = (int)readLE(file.data + 28, 2);
+        uint32_t compression = readLE(file.data + 30, 4);
+        // Positive heights store rows bottom-up.
+        bool bottomUp = h > 0;
+        if (h < 0) h = -h;
+        // 32-bit files may declare bitfields, the common BGRA masks are assumed.
+        if ((bits != 24 && bits != 32) || (compression != 0 && compression != 3) || w <= 0 || h <= 0) return false;
+        size_t pitch = ((size_t)w * bits / 8 + 3) & ~(size_t)3;
+        if (offset + pitch * h > file.size) return false;
+
+        image.reset(new Image(w, h, format));
+        uint32_t packedKey = image->pack(opaqueKey);
+        for (int y = 0; y < h; ++y) {
+            auto *row = image->data + (size_t)y * image->stride;
+            uint8_t const* src = file.data + offset + pitch * (bottomUp ? h - 1 - y : y);
+            if (bits == 24) {
+                // Rows are B, G, R: swizzling them as R, G, B swaps red and blue back.
+                swizzleRGBSpan(row, src, w, !bgrx);
+                applyKey(row, w, packedKey);
+                continue;
+            }
+            for (int x = 0; x < w; ++x) {
+                auto const* p = src + x * 4;
+                color8 c;
+                c.r = p[2];
+                c.g = p[1];
+                c.b = p[0];
+                row[x] = p[3] < 128 ? 0 : image->pack(c);
+                if (row[x] == packedKey) row[x] = 0;
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,22 @@
+#ifndef _ATLAS_H
+#define _ATLAS_H
+
+#include <memory>
+#include "image.h"
+
+/**
+ * Sprites packed into one image, loaded from an uncompressed file.
+ * - Binary PPM (P6, 8-bit) and BMP (24 or 32-bit, uncompressed) are read from a memory mapping
+ *   of the file, each row is converted straight from the mapping into packed pixels of the
+ *   display format. Drawing then copies pixels without any conversion.
+ * - Pixels of the color key become 0, which sprite draws treat as transparent.
+ *   In 32-bit BMP, pixels with alpha below half are transparent too.
+ */
+struct SpriteAtlas {
+    std::unique_ptr<Image> image;
+
+    // Returns false if the file cannot be mapped or is not a supported format, image is then unset.
+    bool load(char const* path, PixelFormat format, color8 const& key);
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "command.h"
+#include <algorithm>
+#include "font.h"
+#include "indexed.h"
+#include "heatmap.h"
+
+static char const* __draw_site = "other";
+
+DrawSite::DrawSite(char const* name)
+    : previous(__draw_site) {
+    __draw_site = name;
+}
+
+DrawSite::~DrawSite() {
+    __draw_site = previous;
+}
+
+char const* DrawSite::current() {
+    return __draw_site;
+}
+
+CommandBuffer::CommandBuffer() {
+    commands.reserve(capacity);
+    text.reserve(textCapacity);
+    layers.reserve(layerCapacity);
+    sites.reserve(capacity);
+}
+
+void CommandBuffer::record(Image & image) {
+    clear();
+    target = &image;
+    image.recorder = this;
+}
+
+void CommandBuffer::stop() {
+    if (target) target->recorder = nullptr;
+    target = nullptr;
+}
+
+void CommandBuffer::clear() {
+    commands.clear();
+    text.clear();
+    layers.clear();
+    sites.clear();
+    flushed = false;
+}
+
+void CommandBuffer::flush() {
+    if (!target) return;
+    if (heatmap) heatmap->accumulate(*this);
+    if (indexed) {
+        indexed->execute(*this);
+    }
+    else {
+        execute(target->view());
+    }
+    commands.clear();
+    text.clear();
+    layers.clear();
+    sites.clear();
+    flushed = true;
+}
+
+Command & CommandBuffer::push(CommandType type, Image::dataType pixel, Rect const& bounds) {
+    if ((int)commands.size() == capacity) flush();
+    Command command = {};
+    command.type = type;
+    command.pixel = pixel;
+    command.bounds = bounds;
+    commands.push_back(command);
+    sites.push_back(DrawSite::current());
+    return commands.back();
+}
+
+void CommandBuffer::fillRect(Rect const& r, Image::dataType pixel) {
+    push(CommandType::FillRect, pixel, r);
+}
+
+void CommandBuffer::outlineRect(Rect const& r, Rect const& bounds, int thickness, Image::dataType pixel) {
+    auto & command = push(CommandType::OutlineRect, pixel, bounds);
+    command.x = r.x0;
+    command.y = r.y0;
+    command.x1 = r.x1;
+    command.y1 = r.y1;
+    command.scale = thickness;
+}
+
+void CommandBuffer::glyphRun(char const* str, int count, int x, int y, Image::dataType pixel, int scale) {
+    if ((int)text.size() + count > textCapacity) flush();
+    auto & command = push(CommandType::GlyphRun, pixel, {
+        x, y, x + count * __glyph_advance * scale, y + __glyph_h * scale,
+    });
+    command.x = x;
+    command.y = y;
+    command.scale = scale;
+    command.text = (int)text.size();
+    command.count = count;
+    text.insert(text.end(), str, str + count);
+}
+
+void CommandBuffer::line(Segment const& s, Rect const& bounds, Image::dataType pixel) {
+    auto & command = push(CommandType::Line, pixel, bounds);
+    command.x = s.x0;
+    command.y = s.y0;
+    command.x1 = s.x1;
+    command.y1 = s.y1;
+}
+
+Command & CommandBuffer::pushLayer(CommandType type, Image const& source, Rect const& r, uint64_t key) {
+    // Flush before looking up the layer, so push below cannot drop its index.
+    if ((int)commands.size() == capacity) flush();
+    auto it = std::find(layers.begin(), layers.end(), &source);
+    if (it == layers.end()) {
+        if ((int)layers.size() == layerCapacity) flush();
+        layers.push_back(&source);
+        it = layers.end() - 1;
+    }
+    int index = (int)(it - layers.begin());
+    auto & command = push(type, 0, r);
+    command.text = index;
+    command.x = (int32_t)(key & 0xFFFFFFFFu);
+    command.y = (int32_t)(key >> 32);
+    return command;
+}
+
+void CommandBuffer::layer(Image const& source, Rect const& r, uint64_t key) {
+    pushLayer(CommandType::Layer, source, r, key);
+}
+
+void CommandBuffer::upscale(Image const& source, int factor, Rect const& r, uint64_t key) {
+    pushLayer(CommandType::Upscale, source, r, key).scale = factor;
+}
+
+void CommandBuffer::sprite(Image const& atlas, Rect const& s, Rect const& r, int ox, int oy) {
+    // The atlas never changes, its address alone identifies the content.
+    auto & command = pushLayer(CommandType::Sprite, atlas, r, 0);
+    command.x = ox;
+    command.y = oy;
+    command.x1 = s.x0;
+    command.y1 = s.y0;
+    command.scale = s.x1 - s.x0;
+    command.count = s.y1 - s.y0;
+}
+
+uint64_t CommandBuffer::hash() const {
+    // Command is all 32-bit fields, so there is no padding to hash.
+    static_assert(sizeof(Command) == 13 * sizeof(int32_t), "Command must not have padding");
+    uint64_t h = fnv1a(commands.data(), commands.size() * sizeof(Command));
+    h = fnv1a(layers.data(), layers.size() * sizeof(Image const*), h);
+    return fnv1a(text.data(), text.size(), h);
+}
+
+void CommandBuffer::execute(ImageView const& view) const {
+    for (auto const& command : commands) execute(view, command);
+}
+
+void CommandBuffer::execute(ImageView const& view, Command const& command) const {
+    switch (command.type) {
+    case CommandType::FillRect:
+        view.fillRect(command.bounds, command.pixel);
+        break;
+    case CommandType::OutlineRect:
+        view.outline({ command.x, command.y, command.x1, command.y1 }, command.scale, command.pixel);
+        break;
+    case CommandType::GlyphRun:
+        rasterGlyphs(view, text.data() + command.text, command.count,
+            command.x, command.y, command.pixel, command.scale);
+        break;
+    case CommandType::Line:
+        view.line(command.x, command.y, command.x1, command.y1, command.pixel);
+        break;
+    case CommandType::Layer:
+        view.composite(layers[command.text]->view(), command.bounds);
+        break;
+    case CommandType::Upscale:
+        view.upscale(layers[command.text]->view(), command.scale, command.bounds);
+        break;
+    case CommandType::Sprite:
+        view.sprite(layers[command.text]->view(), {
+            command.x1, command.y1, command.x1 + command.scale, command.y1 + command.count,
+        }, command.x, command.y, command.bounds);
+        break;
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef _COMMAND_H
+#define _COMMAND_H
+
+#include <vector>
+#include <cstdint>
+#include "image.h"
+#include "line.h"
+
+enum struct CommandType {
+    FillRect,
+    OutlineRect,
+    GlyphRun,
+    Line,
+    Layer,
+    Upscale,
+    Sprite,
+};
+
+/**
+ * One recorded draw call.
+ * - Coordinates are in memory rows (top-down), flip is already resolved.
+ * - bounds covers every pixel the command may write, but is not clipped,
+ *   so it can be tested against any clip rect.
+ */
+struct Command {
+    CommandType type;
+    Image::dataType pixel;
+    Rect bounds;
+    // OutlineRect: rect (x, y) to (x1, y1), border thickness in scale.
+    // GlyphRun: origin, scale and text[text, text + count) in CommandBuffer::text.
+    // Line: endpoints (x, y) to (x1, y1).
+    // Layer: CommandBuffer::layers[text] composited over bounds, content key in (x, y).
+    // Upscale: CommandBuffer::layers[text] scaled by scale over bounds, content key in (x, y).
+    // Sprite: scale x count pixels at (x1, y1) of CommandBuffer::layers[text] repeated over bounds from (x, y).
+    int x, y;
+    int x1, y1;
+    int scale;
+    int text, count;
+};
+
+struct IndexedImage;
+struct Heatmap;
+
+/**
+ * Names the code issuing draw calls while in scope, for the heatmap.
+ * - Sites nest, commands are tagged with the innermost one.
+ * - name must outlive the recorded frame, use string literals.
+ */
+struct DrawSite {
+    explicit DrawSite(char const* name);
+    ~DrawSite();
+    DrawSite(DrawSite const&) = delete;
+    DrawSite & operator=(DrawSite const&) = delete;
+
+    // Innermost site in scope, "other" outside any.
+    static char const* current();
+
+private:
+    char const* previous;
+};
+
+/**
+ * Flat draw command buffer.
+ * - Storage is reserved once, recording a frame never allocates.
+ * - When it runs full, recorded commands are executed into the target image
+ *   and recording continues from empty, flushed is then set for the frame.
+ */
+struct CommandBuffer {
+    static constexpr int capacity = 4096;
+    static constexpr int textCapacity = 16384;
+    static constexpr int layerCapacity = 16;
+
+    std::vector<Command> commands;
+    std::vector<char> text;
+    std::vector<Image const*> layers;
+    // DrawSite of each command, not part of the hash.
+    std::vector<char const*> sites;
+    bool flushed = false;
+    // When set, a full buffer is executed into indexed instead of the recorded image.
+    IndexedImage *indexed = nullptr;
+    // When set, a full buffer is counted into heatmap before it is executed.
+    Heatmap *heatmap = nullptr;
+
+    CommandBuffer();
+
+    // Start recording draw calls made on image, clears the buffer.
+    void record(Image & image);
+    // Stop recording, the buffer keeps its commands for execution.
+    void stop();
+    void clear();
+
+    void fillRect(Rect const& r, Image::dataType pixel);
+    void outlineRect(Rect const& r, Rect const& bounds, int thickness, Image::dataType pixel);
+    void glyphRun(char const* str, int count, int x, int y, Image::dataType pixel, int scale);
+    // bounds holds the pixels of s inside the image, see clipLine.
+    void line(Segment const& s, Rect const& bounds, Image::dataType pixel);
+    void layer(Image const& source, Rect const& r, uint64_t key);
+    void upscale(Image const& source, int factor, Rect const& r, uint64_t key);
+    void sprite(Image const& atlas, Rect const& s, Rect const& r, int ox, int oy);
+
+    // Hash of the recorded stream, equal hashes draw equal pixels on equal images.
+    uint64_t hash() const;
+
+    // Execute commands in order, writing only pixels inside view.
+    void execute(ImageView const& view) const;
+    void execute(ImageView const& view, Command const& command) const;
+
+private:
+    void flush();
+    Command & push(CommandType type, Image::dataType pixel, Rect const& bounds);
+    // Push a command drawing source, stored in layers.
+    Command & pushLayer(CommandType type, Image const& source, Rect const& r, uint64_t key);
+
+    Image *target = nullptr;
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef _FONT_H
+#define _FONT_H
+
+#include "image.h"
+
+// Glyphs are 5x7 pixels, followed by a blank column.
+int const __glyph_w = 5;
+int const __glyph_h = 7;
+int const __glyph_advance = 6;
+
+/**
+ * Rasterize count glyphs of text with the top-left corner at (x, y).
+ * - Coordinates are in memory rows (top-down), each glyph pixel is scale x scale.
+ * - Only pixels inside view are written, nothing is recorded or marked dirty.
+ */
+template<typename T>
+void rasterGlyphs(PixelView<T> const& view, char const* text, int count, int x, int y, T pixel, int scale);
+
+// Draw a glyph run, recorded instead if the image is recording.
+void drawGlyphs(Image & image, char const* text, int count, int x, int y, Image::dataType pixel, int scale);
+
+#endif
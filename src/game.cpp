@@ -1,21 +1,58 @@
 #include "game.h"
+#include "command.h"
 
-static void fillRect(Image & image, float2 const& position, float2 const& dim, colorf const& color) {
-    int x0 = std::max(ftoi(position.x), 0);
-    int y0 = std::max(ftoi(position.y), 0);
-    int x1 = std::min(ftoi(position.x + dim.x), image.width);
-    int y1 = std::min(ftoi(position.y + dim.y), image.height);
+static int floorDiv(int a, int b) {
+    return a >= 0 ? a / b : -((b - 1 - a) / b);
+}
 
-    for (int x = x0; x < x1; ++x) for (int y = y0; y < y1; ++y) {
-        image.setPixel(x, y, color, true);
-    }
+// Target pixels the scene rect [min, max) touches, before clipping.
+static Rect sceneRect(SceneTarget const& target, float2 const& min, float2 const& max) {
+    int x0 = ftoi(min.x);
+    int y0 = ftoi(min.y) - target.camera;
+    int x1 = ftoi(max.x);
+    int y1 = ftoi(max.y) - target.camera;
+    // Flip to window rows, then cover every target pixel the rect touches so thin rects never vanish.
+    int k = target.factor;
+    int h = target.windowHeight;
+    return {
+        floorDiv(x0, k),
+        floorDiv(h - y1, k),
+        floorDiv(x1 + k - 1, k),
+        floorDiv(h - y0 + k - 1, k),
+    };
+}
+
+// Target pixel holding scene point p.
+static int2 targetPoint(SceneTarget const& target, float2 const& p) {
+    int k = target.factor;
+    return { floorDiv(ftoi(p.x), k), floorDiv(target.windowHeight - 1 - (ftoi(p.y) - target.camera), k) };
+}
+
+static Rect targetRect(SceneTarget const& target, float2 const& min, float2 const& max) {
+    Rect r = sceneRect(target, min, max);
+    auto const& clip = target.clip;
+    return {
+        std::max(r.x0, clip.x0),
+        std::max(r.y0, clip.y0),
+        std::min(r.x1, clip.x1),
+        std::min(r.y1, clip.y1),
+    };
 }
 
-void ColliderRect::draw(Image & image, float height) const {
-    fillRect(image, {
-        position.x,
-        position.y - height,
-    }, dim, color);
+void ColliderRect::draw(SceneTarget const& target) const {
+    Rect r = targetRect(target, position, position + dim);
+    if (r.empty()) {
+        ++target.counts->collidersCulled;
+        return;
+    }
+    ++target.counts->collidersDrawn;
+    if (target.atlas && !sprite.empty() && target.factor == 1) {
+        // Tiles start at the unclipped corner, so clipped redraws match whole ones.
+        Rect corner = sceneRect(target, position, position + dim);
+        target.image.drawSprite(*target.atlas, sprite, r, corner.x0, corner.y0);
+        return;
+    }
+    target.image.fillRect(r.x0, r.y0, r.x1, r.y1, target.image.pack(color), false);
 }
 
 void ColliderRect::calcBound() {
@@ -37,7 +74,8 @@ void Player::init(Image & image) {
     collider.dim.y = __size;
     collider.position.x = (image.width - collider.dim.x) * 0.5f;
     collider.position.y = (image.height - collider.dim.y) * 0.5f;
-    collider.color = { 1.0f, 0.0f, 0.0f };
+    collider.color = __player_color;
+    collider.sprite = __player_sprite;
     collider.calcBound();
 }
 
@@ -76,12 +114,19 @@ bool Level::isPass(Player const& player) const {
 }
 
 
-void Level::draw(Image & image, float height) const {
+void Level::draw(SceneTarget const& target) const {
+    if (targetRect(target, bound.min, bound.max).empty()) {
+        ++target.counts->levelsCulled;
+        target.counts->collidersCulled += 2 + BRICKS_PER_LEVEL;
+        return;
+    }
+    ++target.counts->levelsDrawn;
+
     // draw gates
-    gates[0].draw(image, height);
-    gates[1].draw(image, height);
+    gates[0].draw(target);
+    gates[1].draw(target);
 
-    for (int i = 0; i < BRICKS_PER_LEVEL; ++i) bricks[i].draw(image, height);
+    for (int i = 0; i < BRICKS_PER_LEVEL; ++i) bricks[i].draw(target);
 }
 
 Level Level::generate(float2 const& position_, float2 const& dim_, int id_) {
@@ -102,12 +147,14 @@ Level Level::generate(float2 const& position_, float2 const& dim_, int id_) {
     level.gates[0].position.y = position_.y;
     level.gates[0].dim.x = enterPosition;
     level.gates[0].dim.y = enterHeight;
+    level.gates[0].sprite = __gate_sprite;
     level.gates[0].calcBound();
 
     level.gates[1].position.x = enterPosition + enterWidth;
     level.gates[1].position.y = position_.y;
     level.gates[1].dim.x = dim_.x - enterPosition - enterWidth;
     level.gates[1].dim.y = enterHeight;
+    level.gates[1].sprite = __gate_sprite;
     level.gates[1].calcBound();
 
     // generate bricks
@@ -121,12 +168,43 @@ Level Level::generate(float2 const& position_, float2 const& dim_, int id_) {
         level.bricks[i].position.y = position_.y + rnd() * dim_.y;
         level.bricks[i].dim.x = __size;
         level.bricks[i].dim.y = __size;
+        level.bricks[i].sprite = __brick_sprite;
         level.bricks[i].calcBound();
     }
 
+    level.bound.min = level.collider.min;
+    level.bound.max = level.collider.max;
+    for (auto const& gate : level.gates) {
+        level.bound.min = float2::min(level.bound.min, gate.min);
+        level.bound.max = float2::max(level.bound.max, gate.max);
+    }
+    for (auto const& brick : level.bricks) {
+        level.bound.min = float2::min(level.bound.min, brick.min);
+        level.bound.max = float2::max(level.bound.max, brick.max);
+    }
+    level.bound.position = level.bound.min;
+    level.bound.dim = level.bound.max - level.bound.min;
+
     return level;
 }
 
+// Dust thrown down and away from the jump, from under the player.
+static void emitJump(Particles & particles, Image const& image, Player const& player) {
+    auto const& c = player.collider;
+    float2 feet = { c.position.x + c.dim.x * 0.5f, c.position.y };
+    float2 velocity = { player.speed.x * -0.5f, -0.5f * __scale };
+    particles.emit(feet, velocity, 0.5f * __scale, 32, 0.5f, image.pack(__dust_color));
+}
+
+// The player bursts into pieces of itself and of the brick it hit.
+static void emitHit(Particles & particles, Image const& image, Player const& player) {
+    auto const& c = player.collider;
+    float2 center = c.position + c.dim * 0.5f;
+    float2 velocity = { 0.0f, 1.0f * __scale };
+    particles.emit(center, velocity, 3.0f * __scale, 400, 1.5f, image.pack(__player_color));
+    particles.emit(center, velocity, 2.0f * __scale, 200, 1.0f, image.pack(__brick_color));
+}
+
 Game::Game(Image & image_)
     : image(image_) {}
 
@@ -137,6 +215,7 @@ void Game::init() {
     displayHeight = image.height * 0.5f;
     player.init(image);
     levels.clear();
+    if (particles) particles->clear();
 
     levels.push_back(Level::generate({
         0, (float)image.height,
@@ -154,6 +233,13 @@ bool Game::isHit() const {
 }
 
 bool Game::tick(UserCommand command, float deltaTime) {
+    player.tick(command, deltaTime);
+    if (particles && command != UserCommand::None) emitJump(*particles, image, player);
+
+    float newHeight = player.collider.position.y - displayHeight;
+    height = std::max(height, newHeight);
+
+    // Levels follow the new height, so a level exists before any of its rows are drawn.
     auto const& back = levels.back();
     if (back.collider.max.y - height < (float)image.height) {
         levels.push_back(Level::generate({
@@ -168,24 +254,77 @@ bool Game::tick(UserCommand command, float deltaTime) {
         levels.pop_front();
     }
 
-    player.tick(command, deltaTime);
-
-    float newHeight = player.collider.position.y - displayHeight;
-    height = std::max(height, newHeight);
-
-    if (isHit()) return true;
-
+    bool hit = isHit();
     for (auto const& level : levels) {
-        if (level.isHit(player)) return true;
-        if (level.isPass(player)) {
+        if (hit) break;
+        if (level.isHit(player)) hit = true;
+        else if (level.isPass(player)) {
             score = std::max(score, level.id);
         }
     }
 
-    return false;
+    if (hit && particles) emitHit(*particles, image, player);
+    return hit;
+}
+
+SceneTarget Game::target(Image & destination, int factor) const {
+    return { destination, factor, image.height, camera(), { 0, 0, destination.width, destination.height }, &counts, atlas };
 }
 
 void Game::draw() const {
-    for (auto const& level : levels) level.draw(image, height);
-    player.collider.draw(image, height);
+    draw(image, 1);
+}
+
+void Game::draw(Image & target, int factor) const {
+    SceneTarget scene = this->target(target, factor);
+    drawLevels(scene);
+    drawPlayer(scene);
+}
+
+void Game::drawLevels(SceneTarget const& target) const {
+    DrawSite site("levels");
+    for (auto const& level : levels) level.draw(target);
+}
+
+void Game::drawPlayer(SceneTarget const& target) const {
+    DrawSite site("player");
+    player.collider.draw(target);
+}
+
+void Game::drawOverlay(SceneTarget const& target) const {
+    DrawSite site("overlay");
+    auto & image = target.image;
+
+    auto bounds = image.pack(__bounds_color);
+    Rect rects[3 + BRICKS_PER_LEVEL];
+    for (auto const& level : levels) {
+        if (targetRect(target, level.bound.min, level.bound.max).empty()) continue;
+        int n = 0;
+        rects[n++] = sceneRect(target, level.bound.min, level.bound.max);
+        for (auto const& gate : level.gates) rects[n++] = sceneRect(target, gate.min, gate.max);
+        for (auto const& brick : level.bricks) rects[n++] = sceneRect(target, brick.min, brick.max);
+        image.drawOutlines(rects, n, 1, bounds, false);
+    }
+
+    // Stepped like Player::tick, from the player's center.
+    constexpr int steps = 30;
+    constexpr float deltaTime = 1.0f / steps;
+    Segment path[steps];
+    float2 const speeds[3] = {
+        player.speed,
+        { -player.jumpSpeedX, player.jumpSpeedY },
+        { player.jumpSpeedX, player.jumpSpeedY },
+    };
+    for (auto speed : speeds) {
+        float2 position = player.collider.position + player.collider.dim * 0.5f;
+        int2 a = targetPoint(target, position);
+        for (auto & segment : path) {
+            speed = speed + player.gravity * deltaTime;
+            position = position + speed * deltaTime;
+            int2 b = targetPoint(target, position);
+            segment = { a.x, a.y, b.x, b.y };
+            a = b;
+        }
+        image.drawLines(path, steps, __path_color, false);
+    }
 }
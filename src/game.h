@@ -4,11 +4,57 @@
 #include <list>
 #include "macro.h"
 #include "image.h"
+#include "line.h"
+#include "particles.h"
 
 #define BRICKS_PER_LEVEL 4
 
 constexpr float __scale = 100.0f;
 constexpr float __size = 20.0f;
+constexpr color8 __brick_color = { 1.0f, 1.0f, 1.0f };
+constexpr color8 __player_color = { 1.0f, 0.0f, 0.0f };
+constexpr color8 __bounds_color = { 0.0f, 1.0f, 0.0f };
+constexpr color8 __path_color = { 1.0f, 1.0f, 0.0f };
+constexpr color8 __dust_color = { 0.6f, 0.6f, 0.6f };
+// Sprites in the atlas, __size pixels square.
+constexpr Rect __brick_sprite = { 0, 0, 20, 20 };
+constexpr Rect __gate_sprite = { 20, 0, 40, 20 };
+constexpr Rect __player_sprite = { 40, 0, 60, 20 };
+
+// Scene objects drawn and culled before rasterization, summed by draw calls until reset.
+struct DrawCounts {
+    int64_t levelsDrawn = 0;
+    int64_t levelsCulled = 0;
+    int64_t collidersDrawn = 0;
+    int64_t collidersCulled = 0;
+
+    DrawCounts & operator+=(DrawCounts const& other) {
+        levelsDrawn += other.levelsDrawn;
+        levelsCulled += other.levelsCulled;
+        collidersDrawn += other.collidersDrawn;
+        collidersCulled += other.collidersCulled;
+        return *this;
+    }
+};
+
+/**
+ * Where the scene is drawn.
+ * - Each pixel of image covers factor x factor window pixels.
+ * - Scene y goes up, it is moved down by camera whole pixels and flipped over windowHeight
+ *   before scaling down. The camera moves in whole pixels so scrolled frames line up.
+ * - Only pixels inside clip, in image memory rows, are drawn. Levels and colliders
+ *   with no pixel inside clip are culled whole and counted in counts.
+ * - With atlas set and factor 1, colliders are drawn with their sprite, tiled over their rect.
+ */
+struct SceneTarget {
+    Image & image;
+    int factor;
+    int windowHeight;
+    int camera;
+    Rect clip;
+    DrawCounts *counts;
+    Image const* atlas;
+};
 
 enum struct UserCommand {
     None,
@@ -21,8 +67,10 @@ struct ColliderRect {
     float2 dim;
     float2 min;
     float2 max;
-    colorf color = { 1.0f, 1.0f, 1.0f };
-    void draw(Image & image, float height) const;
+    color8 color = __brick_color;
+    // Rect in the sprite atlas, empty for a flat color.
+    Rect sprite = {};
+    void draw(SceneTarget const& target) const;
     void calcBound();
     bool hit(ColliderRect const& other) const;
 };
@@ -44,10 +92,12 @@ struct Level {
     ColliderRect collider;
     ColliderRect gates[2];
     ColliderRect bricks[BRICKS_PER_LEVEL];
+    // Covers the gates and bricks, bricks may stick out of collider.
+    ColliderRect bound;
 
     bool isHit(Player const& player) const;
     bool isPass(Player const& player) const;
-    void draw(Image & image, float height) const;
+    void draw(SceneTarget const& target) const;
 
     static Level generate(float2 const& position, float2 const& dim, int id);
 };
@@ -60,6 +110,12 @@ struct Game {
     float displayHeight;
     int score;
     int id;
+    // Counted by every draw into a target of this game, reset by the caller once per frame.
+    mutable DrawCounts counts;
+    // Sprites of the scene in the target format, flat colors when unset.
+    Image const* atlas = nullptr;
+    // When set, jumps and the hit ending a game emit particles here, in image's format.
+    Particles *particles = nullptr;
 
     Game(Image & image);
 
@@ -67,7 +123,19 @@ struct Game {
 
     void init();
     bool tick(UserCommand command, float deltaTime);
+    // Scroll of the scene in whole pixels, follows height.
+    int camera() const { return ftoi(height); }
+    // Whole target image at factor, seen from camera().
+    SceneTarget target(Image & destination, int factor) const;
+
     void draw() const;
+    // Draw into target downscaled by factor, target has at least the window size / factor pixels.
+    void draw(Image & target, int factor) const;
+    // Levels and player alone, the player is drawn over the levels.
+    void drawLevels(SceneTarget const& target) const;
+    void drawPlayer(SceneTarget const& target) const;
+    // Outlines of levels and colliders, and the player's path over the next second with and without a jump.
+    void drawOverlay(SceneTarget const& target) const;
 };
 
 #endif
\ No newline at end of file
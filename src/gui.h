@@ -2,24 +2,46 @@
 #define _GUI_H
 
 #include <string>
+#include <vector>
+#include <memory>
 #include "macro.h"
 #include "vector.h"
 #include "platform.h"
 #include "image.h"
 
-colorf const __text_color   = { .9f, .9f, .9f };
-colorf const __base_color   = { .3f, .3f, .3f };
-colorf const __active_color = { .9f, .9f, .9f };
+constexpr color8 __text_color   = { .9f, .9f, .9f };
+constexpr color8 __base_color   = { .3f, .3f, .3f };
+constexpr color8 __active_color = { .9f, .9f, .9f };
 int const __tp = 1;
 
-void fillRect(Image & image, int x, int y, int w, int h, colorf const& color);
+void fillRect(Image & image, int x, int y, int w, int h, color8 const& color);
 
-void drawLineX(Image & image, int x, int y, int w, colorf const& color, int scale = 1);
-void drawLineY(Image & image, int x, int y, int h, colorf const& color, int scale = 1);
-void drawRect(Image & image, int x, int y, int w, int h, colorf const& color, int scale = 1);
+void drawLineX(Image & image, int x, int y, int w, color8 const& color, int scale = 1);
+void drawLineY(Image & image, int x, int y, int h, color8 const& color, int scale = 1);
+void drawRect(Image & image, int x, int y, int w, int h, color8 const& color, int scale = 1);
 
-void drawFont(Image & image, char c, int x, int y, colorf const& color, int scale = 1);
-void drawText(Image & image, char const* text, int x, int y, colorf const& color, int scale = 1);
+void drawFont(Image & image, char c, int x, int y, color8 const& color, int scale = 1);
+void drawText(Image & image, char const* text, int x, int y, color8 const& color, int scale = 1);
+
+// Float color overloads, converted once and forwarded.
+inline void fillRect(Image & image, int x, int y, int w, int h, colorf const& color) {
+    fillRect(image, x, y, w, h, color8(color));
+}
+inline void drawLineX(Image & image, int x, int y, int w, colorf const& color, int scale = 1) {
+    drawLineX(image, x, y, w, color8(color), scale);
+}
+inline void drawLineY(Image & image, int x, int y, int h, colorf const& color, int scale = 1) {
+    drawLineY(image, x, y, h, color8(color), scale);
+}
+inline void drawRect(Image & image, int x, int y, int w, int h, colorf const& color, int scale = 1) {
+    drawRect(image, x, y, w, h, color8(color), scale);
+}
+inline void drawFont(Image & image, char c, int x, int y, colorf const& color, int scale = 1) {
+    drawFont(image, c, x, y, color8(color), scale);
+}
+inline void drawText(Image & image, char const* text, int x, int y, colorf const& color, int scale = 1) {
+    drawText(image, text, x, y, color8(color), scale);
+}
 
 struct GUI {
     GUI(int _w, int _h, int _x, int _y, int _scale = 1, bool _flip = false)
@@ -32,6 +54,14 @@ struct GUI {
         oy = y;
     }
 
+    /**
+     * Retained mode: widgets draw into a cached layer of the given format instead of the image,
+     * and a widget is only redrawn when its content key (text, state, position) changes.
+     * - Call composite() after the last widget of a frame to put the layer on the image.
+     */
+    void retain(PixelFormat format);
+    void composite(Image & image);
+
     void processMouseButtonEvent(LuGL::MOUSE_BUTTON button, bool pressed, float x, float y);
     void processMouseDragEvent(float x, float y);
     // Call after drawing every elements in each render loop.
@@ -48,7 +78,23 @@ struct GUI {
     int scale;
     bool flip;
 
+    // Widgets of this frame on the image and culled off it, reset by tick().
+    int widgetsDrawn = 0;
+    int widgetsCulled = 0;
+
 private:
+    // Where a widget covering rect should draw, or nullptr if its cached pixels are still valid
+    // or it has no pixel on the image.
+    Image * beginWidget(Image & image, uint64_t key, Rect const& rect);
+
+    struct Widget {
+        uint64_t key;
+        Rect rect;
+    };
+    std::unique_ptr<Image> layer;
+    std::vector<Widget> widgets;
+    int widgetCount = 0;
+
     float2 mouseLastPos;
     float2 mousePos;
     float2 mouseDelta;
@@ -0,0 +1,109 @@
+#include "heatmap.h"
+#include <algorithm>
+#include <cstdio>
+
+// Heat colors by write count, the last one for every count past it.
+constexpr color8 __heat_colors[] = {
+    { 0.0f, 0.2f, 1.0f },
+    { 0.0f, 1.0f, 0.2f },
+    { 1.0f, 1.0f, 0.0f },
+    { 1.0f, 0.5f, 0.0f },
+    { 1.0f, 0.0f, 0.0f },
+};
+int const __heat_levels = sizeof(__heat_colors) / sizeof(__heat_colors[0]);
+
+Heatmap::Heatmap(int w, int h)
+    : width(w)
+    , height(h)
+    , counts((size_t)w * h, 0)
+    , scratch(w, h) {}
+
+void Heatmap::clear() {
+    std::fill(counts.begin(), counts.end(), 0);
+    writes = 0;
+    covered = 0;
+    sites.clear();
+}
+
+inline void Heatmap::count(int x, int y) {
+    if (counts[(size_t)y * width + x]++ == 0) ++covered;
+}
+
+void Heatmap::accumulate(CommandBuffer const& buffer) {
+    for (size_t i = 0; i < buffer.commands.size(); ++i) {
+        auto const& command = buffer.commands[i];
+        auto view = scratch.view().sub(command.bounds);
+        Rect r = view.bounds();
+        if (r.empty()) continue;
+
+        int64_t n = 0;
+        if (command.type == CommandType::FillRect) {
+            for (int y = r.y0; y < r.y1; ++y) {
+                for (int x = r.x0; x < r.x1; ++x) count(x, y);
+            }
+            n = r.area();
+        }
+        else {
+            // Packed colors are never 0, so every pixel the command wrote is non-zero.
+            view.fillRect(r, 0);
+            buffer.execute(view, command);
+            for (int y = r.y0; y < r.y1; ++y) {
+                auto const* row = view.row(y);
+                for (int x = r.x0; x < r.x1; ++x) {
+                    if (!row[x]) continue;
+                    count(x, y);
+                    ++n;
+                }
+            }
+        }
+        writes += n;
+        addSite(buffer.sites[i], n);
+    }
+}
+
+void Heatmap::addSite(char const* name, int64_t n) {
+    for (auto & site : sites) {
+        if (site.name == name) {
+            site.writes += n;
+            return;
+        }
+    }
+    sites.push_back({ name, n });
+}
+
+float Heatmap::overdraw() const {
+    return covered ? (float)writes / covered : 0.0f;
+}
+
+void Heatmap::overlay(Image & image) const {
+    Image::dataType heat[__heat_levels];
+    for (int i = 0; i < __heat_levels; ++i) heat[i] = image.pack(__heat_colors[i]);
+
+    auto view = image.view();
+    int w = std::min(width, image.width);
+    int h = std::min(height, image.height);
+    for (int y = 0; y < h; ++y) {
+        auto *row = view.row(y);
+        auto const* c = counts.data() + (size_t)y * width;
+        for (int x = 0; x < w; ++x) {
+            if (c[x]) row[x] = heat[std::min<uint32_t>(c[x], __heat_levels) - 1];
+            // A quarter of each channel, the top byte is alpha or padding in both formats.
+            else row[x] = ((row[x] >> 2) & 0x003F3F3Fu) | (row[x] & 0xFF000000u);
+        }
+    }
+}
+
+std::string Heatmap::summary(int topSites) const {
+    char line[128];
+    snprintf(line, sizeof(line), "writes %lld, covered %lld, overdraw %.2f",
+        (long long)writes, (long long)covered, overdraw());
+    std::string result = line;
+
+    auto top = sites;
+    std::sort(top.begin(), top.end(), [](Site const& a, Site const& b) { return a.writes > b.writes; });
+    for (int i = 0; i < std::min(topSites, (int)top.size()); ++i) {
+        snprintf(line, sizeof(line), "%s %s %lld", i ? "," : " |", top[i].name, (long long)top[i].writes);
+        result += line;
+    }
+    return result;
+}
@@ -0,0 +1,53 @@
+#ifndef _HEATMAP_H
+#define _HEATMAP_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "image.h"
+#include "command.h"
+
+/**
+ * Debug count of pixel writes per frame.
+ * - Commands are counted one by one as the batched and tiled renderers write them: fills and
+ *   upscales cover their clipped bounds, glyphs, lines and outlines their own pixels, layers
+ *   their non-zero pixels. The scanline renderer writes less, see ScanlineRenderer::written.
+ * - Writes are also summed per DrawSite, to find where the pixel bandwidth goes.
+ */
+struct Heatmap {
+    struct Site {
+        char const* name;
+        int64_t writes;
+    };
+
+    int width, height;
+    // Writes of each pixel this frame, row by row without padding.
+    std::vector<uint32_t> counts;
+    int64_t writes = 0;
+    // Pixels written at least once.
+    int64_t covered = 0;
+    // Writes per site in first use order.
+    std::vector<Site> sites;
+
+    Heatmap(int w, int h);
+
+    // Start counting a new frame.
+    void clear();
+    // Count the writes of buffer executed on an image of this size.
+    void accumulate(CommandBuffer const& buffer);
+    // Writes per written pixel, 1 when nothing was drawn twice.
+    float overdraw() const;
+    // Color written pixels of image by count, blue once up to red five times or more. The rest is dimmed.
+    void overlay(Image & image) const;
+    // Totals and the top sites by writes, on one line.
+    std::string summary(int topSites) const;
+
+private:
+    void count(int x, int y);
+    void addSite(char const* name, int64_t n);
+
+    // Commands other than fills are rasterized here to see which pixels they write.
+    Image scratch;
+};
+
+#endif
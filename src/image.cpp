@@ -1,70 +1,429 @@
 #include "image.h"
+#include "span.h"
+#include "command.h"
+#include "line.h"
 #include <memory>
+#include <new>
 #include <cstring>
+#include <climits>
 
-Image::Image(int w, int h)
+Image::Image(int w, int h, PixelFormat format_)
     : width(w)
-    , height(h) {
-    int size = w * h * channel();
-    data = new dataType[size];
+    , height(h)
+    , format(format_) {
+    constexpr int pixels = __row_align / sizeof(dataType);
+    stride = (w + pixels - 1) / pixels * pixels;
+    size_t size = (size_t)stride * h;
+    data = static_cast<dataType *>(::operator new[](size * sizeof(dataType), std::align_val_t(__row_align)));
     memset(data, 0, size * sizeof(dataType));
+    dirty.add({ 0, 0, w, h });
 }
 Image::~Image() {
-    delete data;
+    ::operator delete[](data, std::align_val_t(__row_align));
+}
+
+Image::dataType Image::pack(color8 const& color) const {
+    // Pixel words are stored little-endian, so the first byte in memory is the lowest one.
+    switch (format) {
+    case PixelFormat::BGRX:
+        return color.b | (color.g << 8) | (color.r << 16) | (0xFFu << 24);
+    case PixelFormat::RGBA:
+    default:
+        return color.r | (color.g << 8) | (color.b << 16) | ((dataType)color.a << 24);
+    }
+}
+
+Image::dataType Image::pack(colorf const& color) const {
+    return pack(color8(color));
 }
 
 void Image::fill(colorf const& color) {
-    int size = width * height;
-    for (int i = 0; i < size; ++i) {
-        int offset = i * channel();
-        data[offset + 0] = clamp(color.r, 0.0f, 1.0f) * 255;
-        data[offset + 1] = clamp(color.g, 0.0f, 1.0f) * 255;
-        data[offset + 2] = clamp(color.b, 0.0f, 1.0f) * 255;
+    fill(color8(color));
+}
+
+void Image::fill(color8 const& color) {
+    DrawSite site("fill");
+    auto pixel = pack(color);
+    markDirty(0, 0, width, height);
+    if (recorder) {
+        recorder->fillRect({ 0, 0, width, height }, pixel);
+        return;
+    }
+    // Padding is filled too, the whole buffer is a single span.
+    clearSpan(data, stride * height, pixel);
+}
+
+void Image::clearDirty(colorf const& color) {
+    clearDirty(color8(color));
+}
+
+void Image::clearDirty(color8 const& color) {
+    DrawSite site("clear");
+    auto pixel = pack(color);
+    DirtyRegion previous = dirty;
+    dirty.clear();
+    for (int i = 0; i < previous.count; ++i) {
+        auto const& r = previous.rects[i];
+        fillRect(r.x0, r.y0, r.x1, r.y1, pixel, false);
     }
 }
 
+void Image::clearDirty(Image const& background, int factor, uint64_t key) {
+    DrawSite site("restore");
+    DirtyRegion previous = dirty;
+    dirty.clear();
+    for (int i = 0; i < previous.count; ++i) {
+        drawUpscaled(background, factor, previous.rects[i], key);
+    }
+}
+
+void Image::markDirty(int x0, int y0, int x1, int y1) {
+    dirty.add({
+        std::max(x0, 0), std::max(y0, 0),
+        std::min(x1, width), std::min(y1, height),
+    });
+}
+
 void Image::setPixel(int x, int y, colorf const& color, bool flip) {
+    setPixel(x, y, pack(color), flip);
+}
+
+void Image::setPixel(int x, int y, color8 const& color, bool flip) {
+    setPixel(x, y, pack(color), flip);
+}
+
+void Image::setPixel(int x, int y, dataType pixel, bool flip) {
     if (x < 0 || x >= width) return;
     if (y < 0 || y >= height) return;
-    int offset;
+    if (flip) y = height - 1 - y;
+    markDirty(x, y, x + 1, y + 1);
+    if (recorder) {
+        recorder->fillRect({ x, y, x + 1, y + 1 }, pixel);
+        return;
+    }
+    data[x + y * stride] = pixel;
+}
+
+void Image::fillRect(int x0, int y0, int x1, int y1, dataType pixel, bool flip) {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, width);
+    y1 = std::min(y1, height);
+    if (x0 >= x1 || y0 >= y1) return;
+
     if (flip) {
-        offset = (x + (height - 1 - y) * width) * channel();
+        int r0 = height - y1;
+        y1 = height - y0;
+        y0 = r0;
+    }
+    markDirty(x0, y0, x1, y1);
+    if (recorder) {
+        recorder->fillRect({ x0, y0, x1, y1 }, pixel);
+        return;
     }
-    else {
-        offset = (x + y * width) * channel();
+    view().fillRect({ x0, y0, x1, y1 }, pixel);
+}
+
+void Image::drawOutline(int x0, int y0, int x1, int y1, int thickness, dataType pixel, bool flip) {
+    Rect r = { x0, y0, x1, y1 };
+    drawOutlines(&r, 1, thickness, pixel, flip);
+}
+
+void Image::drawOutlines(Rect const* rects, int count, int thickness, dataType pixel, bool flip) {
+    auto v = view();
+    for (int i = 0; i < count; ++i) {
+        Rect r = rects[i];
+        if (flip) {
+            int r0 = height - r.y1;
+            r.y1 = height - r.y0;
+            r.y0 = r0;
+        }
+        // Borders of a rect thinner than thickness stick out of it.
+        Rect bounds = {
+            std::min(r.x0, r.x1 - thickness), std::min(r.y0, r.y1 - thickness),
+            std::max(r.x1, r.x0 + thickness), std::max(r.y1, r.y0 + thickness),
+        };
+        if (bounds.x1 <= 0 || bounds.y1 <= 0 || bounds.x0 >= width || bounds.y0 >= height) continue;
+
+        markDirty(bounds.x0, bounds.y0, bounds.x1, bounds.y1);
+        if (recorder) recorder->outlineRect(r, bounds, thickness, pixel);
+        else v.outline(r, thickness, pixel);
     }
-    data[offset + 0] = clamp(color.r, 0.0f, 1.0f) * 255;
-    data[offset + 1] = clamp(color.g, 0.0f, 1.0f) * 255;
-    data[offset + 2] = clamp(color.b, 0.0f, 1.0f) * 255;
 }
 
 void Image::drawLine(int2 const& v0, int2 const& v1, colorf const& color) {
+    drawLine(v0, v1, color8(color));
+}
 
-    auto x0 = clamp(v0.x, 0, width - 1);
-    auto x1 = clamp(v1.x, 0, width - 1);
-    auto y0 = clamp(v0.y, 0, height - 1);
-    auto y1 = clamp(v1.y, 0, height - 1);
+void Image::drawLine(int2 const& v0, int2 const& v1, color8 const& color) {
+    Segment s = { v0.x, v0.y, v1.x, v1.y };
+    drawLines(&s, 1, color);
+}
 
-    int dx = abs(x1 - x0);
-    int dy = -abs(y1 - y0);
-    int sx = x0 < x1 ? 1 : -1;
-    int sy = y0 < y1 ? 1 : -1;
-    int err = dx + dy; 
-    int e2;
+void Image::drawLines(Segment const* segments, int count, color8 const& color, bool flip) {
+    auto pixel = pack(color);
+    auto v = view();
+    Rect bounds = v.bounds();
+    for (int i = 0; i < count; ++i) {
+        Segment s = segments[i];
+        if (flip) {
+            s.y0 = height - 1 - s.y0;
+            s.y1 = height - 1 - s.y1;
+        }
+        LineSteps steps;
+        if (!clipLine(s, bounds, steps)) continue;
 
-    while (true) {
-        setPixel(x0, y0, color);
+        Rect r = steps.bounds();
+        markDirty(r.x0, r.y0, r.x1, r.y1);
+        if (recorder) recorder->line(s, r, pixel);
+        else v.line(s.x0, s.y0, s.x1, s.y1, pixel);
+    }
+}
+
+void Image::drawLayer(Image const& layer, Rect const& r, uint64_t key) {
+    markDirty(r.x0, r.y0, r.x1, r.y1);
+    if (recorder) {
+        recorder->layer(layer, r, key);
+        return;
+    }
+    view().composite(layer.view(), r);
+}
+
+void Image::drawSprite(Image const& atlas, Rect const& s, Rect const& r, int ox, int oy) {
+    markDirty(r.x0, r.y0, r.x1, r.y1);
+    if (recorder) {
+        recorder->sprite(atlas, s, r, ox, oy);
+        return;
+    }
+    view().sprite(atlas.view(), s, ox, oy, r);
+}
+
+void Image::drawUpscaled(Image const& source, int factor, Rect const& r, uint64_t key) {
+    markDirty(r.x0, r.y0, r.x1, r.y1);
+    if (recorder) {
+        recorder->upscale(source, factor, r, key);
+        return;
+    }
+    view().upscale(source.view(), factor, r);
+}
+
+// Row writers for each pixel type, 32-bit pixels go through the span kernels.
+static void fillPixels(uint32_t *dst, int count, uint32_t pixel) { fillSpan(dst, count, pixel); }
+static void fillPixels(uint8_t *dst, int count, uint8_t pixel) { memset(dst, pixel, count); }
+static void compositePixels(uint32_t *dst, uint32_t const* src, int count) { compositeSpan(dst, src, count); }
+static void copyPixels(uint32_t *dst, uint32_t const* src, int count) { copySpan(dst, src, count); }
+static void copyPixels(uint8_t *dst, uint8_t const* src, int count) { memcpy(dst, src, count); }
+static void upscalePixels(uint32_t *dst, uint32_t const* src, int count, int factor) { upscaleSpan(dst, src, count, factor); }
 
-        if (x0 == x1 && y0 == y1) break;
+static void upscalePixels(uint8_t *dst, uint8_t const* src, int count, int factor) {
+    for (int i = 0; i < count; ++i) memset(dst + i * factor, src[i], factor);
+}
+
+static void compositePixels(uint8_t *dst, uint8_t const* src, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (src[i]) dst[i] = src[i];
+    }
+}
+
+template<typename T>
+PixelView<T> PixelView<T>::sub(Rect const& r) const {
+    int sx0 = std::max(r.x0, x0);
+    int sy0 = std::max(r.y0, y0);
+    int sx1 = std::max(std::min(r.x1, x0 + width), sx0);
+    int sy1 = std::max(std::min(r.y1, y0 + height), sy0);
+    return { row(sy0) + sx0, sx0, sy0, sx1 - sx0, sy1 - sy0, stride };
+}
+
+template<typename T>
+void PixelView<T>::fillRect(Rect const& r, T pixel) const {
+    int rx0 = std::max(r.x0, x0);
+    int ry0 = std::max(r.y0, y0);
+    int rx1 = std::min(r.x1, x0 + width);
+    int ry1 = std::min(r.y1, y0 + height);
+    if (rx0 >= rx1) return;
+    for (int y = ry0; y < ry1; ++y) {
+        fillPixels(row(y) + rx0, rx1 - rx0, pixel);
+    }
+}
+
+template<typename T>
+void PixelView<T>::outline(Rect const& r, int thickness, T pixel) const {
+    int t = thickness;
+    fillRect({ r.x0, r.y0, r.x1, r.y0 + t }, pixel);
+    fillRect({ r.x0, r.y1 - t, r.x1, r.y1 }, pixel);
+    fillRect({ r.x0, r.y0 + t, r.x0 + t, r.y1 - t }, pixel);
+    fillRect({ r.x1 - t, r.y0 + t, r.x1, r.y1 - t }, pixel);
+}
+
+template<typename T>
+void PixelView<T>::composite(PixelView const& src, Rect const& r) const {
+    int rx0 = std::max({ r.x0, x0, src.x0 });
+    int ry0 = std::max({ r.y0, y0, src.y0 });
+    int rx1 = std::min({ r.x1, x0 + width, src.x0 + src.width });
+    int ry1 = std::min({ r.y1, y0 + height, src.y0 + src.height });
+    if (rx0 >= rx1) return;
+    for (int y = ry0; y < ry1; ++y) {
+        compositePixels(row(y) + rx0, src.row(y) + rx0, rx1 - rx0);
+    }
+}
+
+template<typename T>
+void PixelView<T>::copy(PixelView const& src, Rect const& r) const {
+    int rx0 = std::max({ r.x0, x0, src.x0 });
+    int ry0 = std::max({ r.y0, y0, src.y0 });
+    int rx1 = std::min({ r.x1, x0 + width, src.x0 + src.width });
+    int ry1 = std::min({ r.y1, y0 + height, src.y0 + src.height });
+    if (rx0 >= rx1) return;
+    for (int y = ry0; y < ry1; ++y) {
+        copyPixels(row(y) + rx0, src.row(y) + rx0, rx1 - rx0);
+    }
+}
+
+template<typename T>
+void PixelView<T>::upscale(PixelView const& src, int factor, Rect const& r) const {
+    int k = factor;
+    int rx0 = std::max({ r.x0, x0, src.x0 * k });
+    int ry0 = std::max({ r.y0, y0, src.y0 * k });
+    int rx1 = std::min({ r.x1, x0 + width, (src.x0 + src.width) * k });
+    int ry1 = std::min({ r.y1, y0 + height, (src.y0 + src.height) * k });
+    if (rx0 >= rx1) return;
+
+    // Source pixels [sx0, sx1) are whole inside the row, the ends may be partial.
+    int sx0 = (rx0 + k - 1) / k;
+    int sx1 = rx1 / k;
+    for (int y = ry0; y < ry1; ++y) {
+        auto d = row(y);
+        // Rows showing the same source row are copies of the first one.
+        if (y > ry0 && y / k == (y - 1) / k) {
+            copyPixels(d + rx0, row(y - 1) + rx0, rx1 - rx0);
+            continue;
+        }
+        auto s = src.row(y / k);
+        if (sx0 > sx1) {
+            fillPixels(d + rx0, rx1 - rx0, s[rx0 / k]);
+            continue;
+        }
+        if (rx0 < sx0 * k) fillPixels(d + rx0, sx0 * k - rx0, s[rx0 / k]);
+        upscalePixels(d + sx0 * k, s + sx0, sx1 - sx0, k);
+        if (sx1 * k < rx1) fillPixels(d + sx1 * k, rx1 - sx1 * k, s[sx1]);
+    }
+}
+
+template<typename T>
+void PixelView<T>::scroll(int dy) const {
+    if (dy <= 0 || dy >= height) return;
+    // Rows that are contiguous move as one block.
+    if (stride == width) {
+        memmove(data + dy * stride, data, (height - dy) * stride * sizeof(T));
+        return;
+    }
+    // Bottom-up, so no row is overwritten before it moved.
+    for (int y = y0 + height - 1; y >= y0 + dy; --y) {
+        copyPixels(row(y) + x0, row(y - dy) + x0, width);
+    }
+}
+
+template<typename T>
+void PixelView<T>::sprite(PixelView const& atlas, Rect const& s, int ox, int oy, Rect const& r) const {
+    int rx0 = std::max(r.x0, x0);
+    int ry0 = std::max(r.y0, y0);
+    int rx1 = std::min(r.x1, x0 + width);
+    int ry1 = std::min(r.y1, y0 + height);
+    int w = s.x1 - s.x0;
+    int h = s.y1 - s.y0;
+    if (rx0 >= rx1 || w <= 0 || h <= 0) return;
+    // Offsets into the tile at the clipped corner, then each row is copied in runs up to the tile edge.
+    int tx0 = ((rx0 - ox) % w + w) % w;
+    int ty = ((ry0 - oy) % h + h) % h;
+    for (int y = ry0; y < ry1; ++y) {
+        auto *d = row(y);
+        auto const* a = atlas.row(s.y0 + ty) + s.x0;
+        for (int x = rx0, tx = tx0; x < rx1; tx = 0) {
+            int n = std::min(w - tx, rx1 - x);
+            compositePixels(d + x, a + tx, n);
+            x += n;
+        }
+        if (++ty == h) ty = 0;
+    }
+}
+
+template<typename T>
+void PixelView<T>::line(int lx0, int ly0, int lx1, int ly1, T pixel) const {
+    LineSteps steps;
+    if (!clipLine({ lx0, ly0, lx1, ly1 }, bounds(), steps)) return;
+
+    if (steps.delta == 0) {
+        if (steps.xMajor) {
+            fillPixels(row(steps.y) + std::min(steps.x, steps.x1), steps.count, pixel);
+            return;
+        }
+        T *p = row(std::min(steps.y, steps.y1)) + steps.x;
+        for (int i = 0; i < steps.count; ++i, p += stride) *p = pixel;
+        return;
+    }
+
+    // Walk a pointer, the major axis moves every step and the minor one when the error wraps.
+    ptrdiff_t major = steps.xMajor ? steps.stepX : steps.stepY * stride;
+    ptrdiff_t minor = steps.xMajor ? steps.stepY * stride : steps.stepX;
+    T *p = row(steps.y) + steps.x;
+    auto error = steps.error;
+    *p = pixel;
+    for (int i = 1; i < steps.count; ++i) {
+        p += major;
+        error += steps.delta;
+        if (error >= steps.limit) {
+            error -= steps.limit;
+            p += minor;
+        }
+        *p = pixel;
+    }
+}
+
+template struct PixelView<uint32_t>;
+template struct PixelView<uint8_t>;
+
+static Rect unite(Rect const& a, Rect const& b) {
+    return {
+        std::min(a.x0, b.x0), std::min(a.y0, b.y0),
+        std::max(a.x1, b.x1), std::max(a.y1, b.y1),
+    };
+}
 
-        e2 = 2 * err;
-        if (e2 >= dy) {
-            err += dy;
-            x0 += sx;
+static bool touches(Rect const& a, Rect const& b) {
+    return a.x0 <= b.x1 && b.x0 <= a.x1
+        && a.y0 <= b.y1 && b.y0 <= a.y1;
+}
+
+void DirtyRegion::add(Rect r) {
+    if (r.empty()) return;
+
+    while (true) {
+        // Absorb every rectangle r touches, restarting since the grown r may touch earlier ones.
+        for (int i = 0; i < count;) {
+            if (touches(r, rects[i])) {
+                r = unite(r, rects[i]);
+                rects[i] = rects[--count];
+                i = 0;
+            }
+            else {
+                ++i;
+            }
         }
-        if (e2 <= dx) {
-            err += dx;
-            y0 += sy;
+        if (count < capacity) break;
+
+        // Full, merge with the rectangle that grows the least.
+        int best = 0;
+        int bestGrowth = INT_MAX;
+        for (int i = 0; i < count; ++i) {
+            int growth = unite(r, rects[i]).area() - rects[i].area();
+            if (growth < bestGrowth) {
+                best = i;
+                bestGrowth = growth;
+            }
         }
+        r = unite(r, rects[best]);
+        rects[best] = rects[--count];
     }
+
+    rects[count++] = r;
 }
@@ -2,25 +2,201 @@
 #define _IMAGE_H
 
 #include <string>
+#include <cstdint>
+#include <cstddef>
 #include "macro.h"
 
+// Byte order of a packed 32-bit pixel in memory.
+// - RGBA: R, G, B, A (NSBitmapImageRep, most Unix surfaces)
+// - BGRX: B, G, R, X (32-bit Windows DIB)
+enum struct PixelFormat {
+    RGBA,
+    BGRX,
+};
+
+/**
+ * 8-bit RGBA color used by the drawing calls.
+ * - Float colors are converted once here, constant colors can be built at compile time.
+ * - Channels are clamped to [0, 1] and scaled by 255, truncating like the float path did.
+ */
+struct color8 {
+    uint8_t r = 0, g = 0, b = 0, a = 255;
+
+    constexpr color8() = default;
+    constexpr color8(float r_, float g_, float b_)
+        : r(unorm(r_))
+        , g(unorm(g_))
+        , b(unorm(b_)) {}
+    explicit constexpr color8(colorf const& c)
+        : color8(c.r, c.g, c.b) {}
+
+    static constexpr uint8_t unorm(float x) {
+        return x <= 0.0f ? 0 : x >= 1.0f ? 255 : static_cast<uint8_t>(x * 255);
+    }
+};
+
+// Pixel rectangle [x0, x1) x [y0, y1) in memory rows (top-down).
+struct Rect {
+    int x0, y0, x1, y1;
+
+    bool empty() const { return x0 >= x1 || y0 >= y1; }
+    int area() const { return empty() ? 0 : (x1 - x0) * (y1 - y0); }
+};
+
+/**
+ * A short list of rectangles covering every pixel written since the last clear.
+ * - Overlapping or touching rectangles are merged on insertion.
+ * - When the list is full the new rectangle is merged into the one
+ *   whose bounding box grows the least.
+ */
+struct DirtyRegion {
+    static constexpr int capacity = 16;
+    Rect rects[capacity];
+    int count = 0;
+
+    void add(Rect r);
+    void clear() { count = 0; }
+};
+
+// Rows of owned pixel buffers start on cache line boundaries.
+constexpr int __row_align = 64;
+
+struct Segment;
+
+/**
+ * Non-owning view of pixels of type T, packed 32-bit colors or 8-bit palette indices.
+ * - Pixel (x, y) is at row(y)[x], coordinates are those of the image the view was cut from,
+ *   so draw calls keep their coordinates in sub-views.
+ * - stride is in pixels, a negative stride makes a bottom-up view.
+ * - Draw routines clip to bounds() once and then write whole rows without per-pixel checks,
+ *   nothing is recorded or marked dirty.
+ */
+template<typename T>
+struct PixelView {
+    T *data;
+    int x0, y0;
+    int width, height;
+    ptrdiff_t stride;
+
+    T *row(int y) const { return data + (y - y0) * stride - x0; }
+    Rect bounds() const { return { x0, y0, x0 + width, y0 + height }; }
+
+    // View of r clipped to this view.
+    PixelView sub(Rect const& r) const;
+
+    void fillRect(Rect const& r, T pixel) const;
+    // Outline of r with borders thickness pixels wide.
+    void outline(Rect const& r, int thickness, T pixel) const;
+    // Bresenham line from (x0, y0) to (x1, y1), both ends included, clipped as in clipLine.
+    // Horizontal and vertical lines are written as a span or a column.
+    void line(int x0, int y0, int x1, int y1, T pixel) const;
+    // Copy pixels of src inside r that are not 0, src shares this view's coordinates.
+    void composite(PixelView const& src, Rect const& r) const;
+    // Copy pixels of src inside r, src shares this view's coordinates and does not overlap it.
+    void copy(PixelView const& src, Rect const& r) const;
+    // Fill r with src scaled up by factor, pixel (x, y) shows src pixel (x / factor, y / factor).
+    void upscale(PixelView const& src, int factor, Rect const& r) const;
+    // Move every row down by dy rows, the top dy rows keep their old pixels.
+    void scroll(int dy) const;
+    // Copy the non-zero pixels of rect s of atlas repeated over r, the first tile has its corner at (ox, oy).
+    void sprite(PixelView const& atlas, Rect const& s, int ox, int oy, Rect const& r) const;
+};
+
+using ImageView = PixelView<uint32_t>;
+// Palette indices, see IndexedImage.
+using IndexedView = PixelView<uint8_t>;
+
+struct CommandBuffer;
+
+/**
+ * Owning 32-bit framebuffer.
+ * - Rows are stride pixels apart, padded to 64 bytes, and data is 64-byte aligned.
+ * - Draw calls take y in memory rows (top-down), or bottom-up with flip.
+ */
 struct Image {
-    using dataType = unsigned char;
+    using dataType = uint32_t;
     dataType *data;
-    constexpr int channel() const { return 3; }
+    constexpr int channel() const { return 4; }
     int width, height;
+    int stride;
+    PixelFormat format;
+    // Pixels written since the last clearDirty(), starts as the whole image.
+    DirtyRegion dirty;
+    // While set, draw calls are appended here instead of writing pixels.
+    CommandBuffer *recorder = nullptr;
 
-    Image(int w, int h);
+    Image(int w, int h, PixelFormat format = PixelFormat::RGBA);
     ~Image();
+    Image(Image const&) = delete;
+    Image & operator=(Image const&) = delete;
+
+    // Whole image, top-down.
+    ImageView view() const { return { data, 0, 0, width, height, stride }; }
 
+    // Pack color into a pixel word of this image's format.
+    dataType pack(color8 const& color) const;
+    dataType pack(colorf const& color) const;
+
+    void fill(color8 const& color);
     void fill(colorf const& color);
+
+    /**
+     * Fill only what was drawn since the last call with color, instead of the whole image.
+     * - Assumes every pixel outside the dirty region already has this color.
+     * - Afterwards dirty holds the erased rectangles, so presenting dirty after
+     *   drawing the next frame covers both what was erased and what was drawn.
+     */
+    void clearDirty(color8 const& color);
+    void clearDirty(colorf const& color);
+    // Like clearDirty, restoring background upscaled by factor instead of a flat color, see drawUpscaled.
+    void clearDirty(Image const& background, int factor, uint64_t key);
+    // Record pixels in [x0, x1) x [y0, y1) as written, with y in memory rows.
+    void markDirty(int x0, int y0, int x1, int y1);
+    void setPixel(int x, int y, color8 const& color, bool flip = true);
     void setPixel(int x, int y, colorf const& color, bool flip = true);
-    
+    void setPixel(int x, int y, dataType pixel, bool flip = true);
+
+    /**
+     * Fill pixels in [x0, x1) x [y0, y1) row by row.
+     * - Bounds are clipped to the image once, each row is a single span write.
+     * - With flip, y goes bottom-up as in setPixel.
+     */
+    void fillRect(int x0, int y0, int x1, int y1, dataType pixel, bool flip = true);
+    // Outline of [x0, x1) x [y0, y1) with borders thickness pixels wide, flip as in fillRect.
+    void drawOutline(int x0, int y0, int x1, int y1, int thickness, dataType pixel, bool flip = true);
+    // Outlines of count rects at once, flip as in fillRect.
+    void drawOutlines(Rect const* rects, int count, int thickness, dataType pixel, bool flip = true);
+
     /**
      * Rasterize a line using Bresenham algorithm.
-     * - Input coordinates are in image space. 
+     * - Input coordinates are in image space, y goes up.
+     * - Lines are clipped to the image, not clamped, so their slope is kept.
      */
+    void drawLine(int2 const& v0, int2 const& v1, color8 const& color);
     void drawLine(int2 const& v0, int2 const& v1, colorf const& color);
+    // Lines of count segments at once, y goes up with flip, else it is in memory rows.
+    void drawLines(Segment const* segments, int count, color8 const& color, bool flip = true);
+
+    /**
+     * Composite layer over r, pixels that are 0 in layer are transparent.
+     * - layer has the same size and format, r is in memory rows.
+     * - key identifies the layer content inside r, so recorded frames hash differently when it changes.
+     */
+    void drawLayer(Image const& layer, Rect const& r, uint64_t key);
+
+    /**
+     * Fill r with source scaled up by factor, each source pixel covering factor x factor pixels.
+     * - source has the same format and at least size / factor pixels, r is in memory rows.
+     * - key identifies the source content, as in drawLayer.
+     */
+    void drawUpscaled(Image const& source, int factor, Rect const& r, uint64_t key);
+
+    /**
+     * Fill r with sprite s of atlas, repeated from its corner at (ox, oy), pixels that are 0 in atlas are transparent.
+     * - atlas has the same format and does not change while frames are recorded, r is in memory rows.
+     * - Clipping only cuts tiles, so a rect clipped by the caller still shows the same tiles when (ox, oy) is kept.
+     */
+    void drawSprite(Image const& atlas, Rect const& s, Rect const& r, int ox, int oy);
 };
 
 #endif
@@ -0,0 +1,156 @@
+#include "indexed.h"
+#include <new>
+#include <cstring>
+#include <climits>
+#include "font.h"
+#include "span.h"
+
+uint8_t Palette::index(uint32_t pixel) {
+    if (pixel == lastPixel) return lastIndex;
+
+    int found = -1;
+    for (int i = 0; i < count; ++i) {
+        if (colors[i] == pixel) {
+            found = i;
+            break;
+        }
+    }
+    if (found < 0 && count < capacity) {
+        found = count++;
+        colors[found] = pixel;
+    }
+    lastPixel = pixel;
+    lastIndex = found < 0 ? nearest(pixel) : (uint8_t)found;
+    return lastIndex;
+}
+
+uint8_t Palette::nearest(uint32_t pixel) const {
+    int best = 0;
+    int bestDistance = INT_MAX;
+    for (int i = 0; i < count; ++i) {
+        int distance = 0;
+        for (int b = 0; b < 32; b += 8) {
+            int d = (int)((pixel >> b) & 0xFF) - (int)((colors[i] >> b) & 0xFF);
+            distance += d * d;
+        }
+        if (distance < bestDistance) {
+            best = i;
+            bestDistance = distance;
+        }
+    }
+    return (uint8_t)best;
+}
+
+IndexedImage::IndexedImage(int w, int h)
+    : width(w)
+    , height(h) {
+    stride = (w + __row_align - 1) / __row_align * __row_align;
+    size_t size = (size_t)stride * h;
+    data = static_cast<uint8_t *>(::operator new[](size, std::align_val_t(__row_align)));
+    memset(data, 0, size);
+}
+
+IndexedImage::~IndexedImage() {
+    ::operator delete[](data, std::align_val_t(__row_align));
+}
+
+void IndexedImage::fill(uint8_t index) {
+    memset(data, index, (size_t)stride * height);
+}
+
+void IndexedImage::fillRect(Rect const& r, uint8_t index) {
+    // Rects spanning whole rows are one run through the padding, a full-screen clear is a single memset.
+    if (r.x0 <= 0 && r.x1 >= width) {
+        int y0 = std::max(r.y0, 0);
+        int y1 = std::min(r.y1, height);
+        if (y0 < y1) memset(data + (size_t)y0 * stride, index, (size_t)(y1 - y0) * stride);
+        return;
+    }
+    view().fillRect(r, index);
+}
+
+void IndexedImage::compositeLayer(Image const& layer, Rect const& r) {
+    int x0 = std::max(r.x0, 0);
+    int y0 = std::max(r.y0, 0);
+    int x1 = std::min({ r.x1, width, layer.width });
+    int y1 = std::min({ r.y1, height, layer.height });
+    for (int y = y0; y < y1; ++y) {
+        auto src = layer.data + (size_t)y * layer.stride;
+        auto dst = data + (size_t)y * stride;
+        for (int x = x0; x < x1; ++x) {
+            if (src[x]) dst[x] = palette.index(src[x]);
+        }
+    }
+}
+
+void IndexedImage::upscaleLayer(Image const& source, int factor, Rect const& r) {
+    int x0 = std::max(r.x0, 0);
+    int y0 = std::max(r.y0, 0);
+    int x1 = std::min({ r.x1, width, source.width * factor });
+    int y1 = std::min({ r.y1, height, source.height * factor });
+    for (int y = y0; y < y1; ++y) {
+        auto src = source.data + (size_t)(y / factor) * source.stride;
+        auto dst = data + (size_t)y * stride;
+        for (int x = x0; x < x1; ++x) dst[x] = palette.index(src[x / factor]);
+    }
+}
+
+void IndexedImage::spriteLayer(Image const& atlas, Rect const& s, int ox, int oy, Rect const& r) {
+    if (spriteAtlas != &atlas) {
+        spriteIndices.reset(new IndexedImage(atlas.width, atlas.height));
+        for (int y = 0; y < atlas.height; ++y) {
+            auto src = atlas.data + (size_t)y * atlas.stride;
+            auto dst = spriteIndices->data + (size_t)y * spriteIndices->stride;
+            for (int x = 0; x < atlas.width; ++x) dst[x] = src[x] ? palette.index(src[x]) : 0;
+        }
+        spriteAtlas = &atlas;
+    }
+    view().sprite(spriteIndices->view(), s, ox, oy, r);
+}
+
+void IndexedImage::execute(CommandBuffer const& buffer) {
+    auto v = view();
+    for (auto const& command : buffer.commands) {
+        uint8_t index = palette.index(command.pixel);
+        switch (command.type) {
+        case CommandType::FillRect:
+            fillRect(command.bounds, index);
+            break;
+        case CommandType::OutlineRect:
+            v.outline({ command.x, command.y, command.x1, command.y1 }, command.scale, index);
+            break;
+        case CommandType::GlyphRun:
+            rasterGlyphs(v, buffer.text.data() + command.text, command.count,
+                command.x, command.y, index, command.scale);
+            break;
+        case CommandType::Line:
+            v.line(command.x, command.y, command.x1, command.y1, index);
+            break;
+        case CommandType::Layer:
+            compositeLayer(*buffer.layers[command.text], command.bounds);
+            break;
+        case CommandType::Upscale:
+            upscaleLayer(*buffer.layers[command.text], command.scale, command.bounds);
+            break;
+        case CommandType::Sprite:
+            spriteLayer(*buffer.layers[command.text], {
+                command.x1, command.y1, command.x1 + command.scale, command.y1 + command.count,
+            }, command.x, command.y, command.bounds);
+            break;
+        }
+    }
+}
+
+void IndexedImage::present(ImageView const& dst, DirtyRegion const& region) const {
+    for (int i = 0; i < region.count; ++i) {
+        auto const& r = region.rects[i];
+        int x0 = std::max(r.x0, 0);
+        int y0 = std::max(r.y0, 0);
+        int x1 = std::min(r.x1, width);
+        int y1 = std::min(r.y1, height);
+        if (x0 >= x1) continue;
+        for (int y = y0; y < y1; ++y) {
+            expandIndexedSpan(dst.row(y) + x0, data + (size_t)y * stride + x0, x1 - x0, palette.colors, palette.count);
+        }
+    }
+}
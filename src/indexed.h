@@ -0,0 +1,67 @@
+#ifndef _INDEXED_H
+#define _INDEXED_H
+
+#include <cstdint>
+#include <memory>
+#include "image.h"
+#include "command.h"
+
+/**
+ * Colors of an IndexedImage as packed pixels of the presented image's format.
+ * - Index 0 is the zero pixel new images start with, other colors take the next free index on first use.
+ * - Once full, new colors map to the nearest color already in the palette.
+ */
+struct Palette {
+    static constexpr int capacity = 256;
+    // Entries past count stay 0, the expansion kernels may read the first 16.
+    uint32_t colors[capacity] = {};
+    int count = 1;
+
+    uint8_t index(uint32_t pixel);
+
+private:
+    uint8_t nearest(uint32_t pixel) const;
+
+    // Draw calls come in runs of one color, the last lookup is kept.
+    uint32_t lastPixel = 0;
+    uint8_t lastIndex = 0;
+};
+
+/**
+ * 8-bit palette-indexed framebuffer.
+ * - Recorded frames are executed as 1-byte indices instead of 4-byte pixels,
+ *   and expanded to packed pixels only where the frame is presented.
+ * - Rows are padded and aligned like Image.
+ */
+struct IndexedImage {
+    uint8_t *data;
+    int width, height;
+    int stride;
+    Palette palette;
+
+    IndexedImage(int w, int h);
+    ~IndexedImage();
+    IndexedImage(IndexedImage const&) = delete;
+    IndexedImage & operator=(IndexedImage const&) = delete;
+
+    IndexedView view() const { return { data, 0, 0, width, height, stride }; }
+
+    // Set every pixel to index with a single memset.
+    void fill(uint8_t index);
+    // Execute commands in order, their colors are mapped to indices through palette.
+    void execute(CommandBuffer const& buffer);
+    // Expand the pixels in region into dst, which has this image's size.
+    void present(ImageView const& dst, DirtyRegion const& region) const;
+
+private:
+    void fillRect(Rect const& r, uint8_t index);
+    void compositeLayer(Image const& layer, Rect const& r);
+    void upscaleLayer(Image const& source, int factor, Rect const& r);
+    void spriteLayer(Image const& atlas, Rect const& s, int ox, int oy, Rect const& r);
+
+    // The atlas of the last sprite mapped to indices once, atlases do not change.
+    Image const* spriteAtlas = nullptr;
+    std::unique_ptr<IndexedImage> spriteIndices;
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "line.h"
+#include <algorithm>
+
+// Pixel i of a line with major length n and minor length m is m * i / n steps along the
+// minor axis, rounded to nearest: (2 * m * i + n) / (2 * n), the remainder being the error.
+
+// First step whose pixel is q or more minor steps away from the start, n + 1 if none.
+static int64_t firstStep(int64_t q, int64_t n, int64_t m) {
+    if (q <= 0) return 0;
+    if (m == 0) return n + 1;
+    return std::min(n + 1, (2 * n * q - n + 2 * m - 1) / (2 * m));
+}
+
+// Steps [i0, i1] of a line starting at a, moving by s, that stay inside [lo, hi).
+static void clipAxis(int64_t a, int s, int64_t lo, int64_t hi, int64_t & i0, int64_t & i1) {
+    if (s > 0) {
+        i0 = std::max(i0, lo - a);
+        i1 = std::min(i1, hi - 1 - a);
+    }
+    else {
+        i0 = std::max(i0, a - (hi - 1));
+        i1 = std::min(i1, a - lo);
+    }
+}
+
+Rect LineSteps::bounds() const {
+    return { std::min(x, x1), std::min(y, y1), std::max(x, x1) + 1, std::max(y, y1) + 1 };
+}
+
+bool clipLine(Segment const& s, Rect const& clip, LineSteps & steps) {
+    if (clip.empty()) return false;
+    int64_t dx = (int64_t)s.x1 - s.x0;
+    int64_t dy = (int64_t)s.y1 - s.y0;
+    int sx = dx < 0 ? -1 : 1;
+    int sy = dy < 0 ? -1 : 1;
+    bool xMajor = std::abs(dx) >= std::abs(dy);
+
+    // Major axis a, minor axis b.
+    int64_t n = xMajor ? std::abs(dx) : std::abs(dy);
+    int64_t m = xMajor ? std::abs(dy) : std::abs(dx);
+    int64_t a0 = xMajor ? s.x0 : s.y0;
+    int64_t b0 = xMajor ? s.y0 : s.x0;
+    int sa = xMajor ? sx : sy;
+    int sb = xMajor ? sy : sx;
+    int64_t alo = xMajor ? clip.x0 : clip.y0;
+    int64_t ahi = xMajor ? clip.x1 : clip.y1;
+    int64_t blo = xMajor ? clip.y0 : clip.x0;
+    int64_t bhi = xMajor ? clip.y1 : clip.x1;
+
+    int64_t i0 = 0;
+    int64_t i1 = n;
+    clipAxis(a0, sa, alo, ahi, i0, i1);
+    // Minor steps [q0, q1] stay inside, the minor position only ever moves one way.
+    int64_t q0 = 0;
+    int64_t q1 = m;
+    clipAxis(b0, sb, blo, bhi, q0, q1);
+    if (q0 > q1) return false;
+    i0 = std::max(i0, firstStep(q0, n, m));
+    i1 = std::min(i1, firstStep(q1 + 1, n, m) - 1);
+    if (i0 > i1) return false;
+
+    auto minorAt = [&](int64_t i) { return n == 0 ? 0 : (2 * m * i + n) / (2 * n); };
+    int64_t a = a0 + sa * i0;
+    int64_t b = b0 + sb * minorAt(i0);
+    int64_t a1 = a0 + sa * i1;
+    int64_t b1 = b0 + sb * minorAt(i1);
+    steps.x = (int)(xMajor ? a : b);
+    steps.y = (int)(xMajor ? b : a);
+    steps.x1 = (int)(xMajor ? a1 : b1);
+    steps.y1 = (int)(xMajor ? b1 : a1);
+    steps.count = (int)(i1 - i0 + 1);
+    steps.xMajor = xMajor;
+    steps.stepX = sx;
+    steps.stepY = sy;
+    steps.limit = 2 * n;
+    steps.delta = 2 * m;
+    steps.error = n == 0 ? 0 : (2 * m * i0 + n) % (2 * n);
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef _LINE_H
+#define _LINE_H
+
+#include <cstdint>
+#include "image.h"
+
+// Line from (x0, y0) to (x1, y1), both ends included, coordinates within +-2^29.
+struct Segment {
+    int x0, y0, x1, y1;
+};
+
+/**
+ * Pixels of a Bresenham line that fall inside a clip rect.
+ * - Clipping cuts the line's steps along its major axis instead of moving its ends,
+ *   so the pixels kept are exactly those of the whole line inside the rect,
+ *   and lines split across tiles or bands join without seams.
+ * - From (x, y) the line takes count pixels, each step moves one pixel along the major axis
+ *   and one along the other when error reaches limit. (x1, y1) is the last pixel.
+ */
+struct LineSteps {
+    int x, y;
+    int x1, y1;
+    int count;
+    bool xMajor;
+    int stepX, stepY;
+    int64_t error, delta, limit;
+
+    // Pixels of the line inside the clip rect.
+    Rect bounds() const;
+};
+
+// Clip s to clip, false when it has no pixel inside.
+bool clipLine(Segment const& s, Rect const& clip, LineSteps & steps);
+
+#endif
@@ -3,20 +3,29 @@
 
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <cstddef>
 #include "vector.h"
 
 #define SETUP_FPS()             \
 float fixed_delta = 0.16f;      \
 float from_last_fixed = 0.0f;   \
-int frame_since_last_fixed = 0
+int frame_since_last_fixed = 0; \
+int64_t late_at_last_fixed = 0
 
-#define UPDATE_FPS() do {                                               \
+// late_frames counts frames that missed their deadline so far, see FramePacer.
+#define UPDATE_FPS(late_frames) do {                                    \
 t.update();                                                             \
 from_last_fixed += t.deltaTime();                                       \
 ++frame_since_last_fixed;                                               \
 if (from_last_fixed > fixed_delta) {                                    \
     int fps = std::round(frame_since_last_fixed / from_last_fixed);     \
     std::string title = "Bricks @ LuGL FPS: " + std::to_string(fps);    \
+    if ((late_frames) > late_at_last_fixed) {                           \
+        title += " late: "                                              \
+            + std::to_string((late_frames) - late_at_last_fixed);       \
+    }                                                                   \
+    late_at_last_fixed = (late_frames);                                 \
     setWindowTitle(window, title.c_str());                              \
     from_last_fixed = 0.0f;                                             \
     frame_since_last_fixed = 0;                                         \
@@ -41,6 +50,16 @@ inline float itof(int x) {
     return x + 0.5f;
 }
 
+// 64-bit FNV-1a, continue a hash by passing the previous result as h.
+inline uint64_t fnv1a(void const* data, size_t size, uint64_t h = 0xCBF29CE484222325ull) {
+    auto bytes = static_cast<unsigned char const*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
 template<typename T, typename U, typename V>
 inline T clamp(T x, U min, V max) {
     x = x < min ? min : x;
@@ -1,12 +1,26 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <cstring>
+#include <memory>
 #include "platform.h"
 #include "macro.h"
 #include "image.h"
 #include "timer.h"
 #include "game.h"
 #include "gui.h"
+#include "command.h"
+#include "tile.h"
+#include "renderer.h"
+#include "indexed.h"
+#include "scanline.h"
+#include "resolution.h"
+#include "scroll.h"
+#include "heatmap.h"
+#include "atlas.h"
+#include "shared.h"
+#include "pacer.h"
+#include "present.h"
 
 // A simple window API that support frame buffer swapping.
 // I transported this window API from my software renderer project:
@@ -17,6 +31,7 @@ static void keyboardEventCallback(AppWindow *window, KEY_CODE key, bool pressed)
 static void mouseButtonEventCallback(AppWindow *window, MOUSE_BUTTON button, bool pressed, float x, float y);
 static void mouseScrollEventCallback(AppWindow *window, float offset);
 static void mouseDragEventCallback(AppWindow *window, float x, float y);
+static void swapRects(AppWindow *window, Rect const* rects, int count);
 
 int const scr_W = 512;
 int const scr_H = 824;
@@ -26,11 +41,79 @@ static AppWindow *window;
 GUI gui(scr_W, scr_H, 10, 10, 2);
 
 int main(int argc, char* argv[]) {
+    // --tiled: rasterize recorded frames in parallel tiles.
+    // --scanline: write each pixel of rect fills once.
+    // --indexed: draw 8-bit palette indices, expanded to pixels at present.
+    // --dynres: render the scene below window resolution when frames run over budget.
+    // --scroll: move the last frame with the camera and draw only what scrolled in, unused with --dynres.
+    // --heatmap: show how often each pixel was written instead of the frame, and print write totals.
+    // --sprites: draw bricks, gates and player from assets/atlas.ppm instead of flat colors.
+    // --overlay: outline colliders and draw the player's paths over the scene.
+    // --fixed-step: advance the game by 1/60 s each frame instead of the time it took, so runs repeat exactly.
+    // --share[=name]: publish presented frames to POSIX shared memory, "/bricks" by default, see tools/frameview.cpp.
+    // --fps=N: pace frames to N per second, 60 by default, 0 runs them back to back.
+    // --buffers=N: present on a thread of its own through N = 2 or 3 buffers, 1 presents on the main thread.
+    bool tiled = false;
+    bool scanline = false;
+    bool indexed = false;
+    bool dynres = false;
+    bool scrolling = false;
+    bool heat = false;
+    bool sprites = false;
+    bool overlay = false;
+    bool fixedStep = false;
+    char const* share = nullptr;
+    double fps = 60.0;
+    int buffers = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--tiled") == 0) tiled = true;
+        if (strcmp(argv[i], "--scanline") == 0) scanline = true;
+        if (strcmp(argv[i], "--indexed") == 0) indexed = true;
+        if (strcmp(argv[i], "--dynres") == 0) dynres = true;
+        if (strcmp(argv[i], "--scroll") == 0) scrolling = true;
+        if (strcmp(argv[i], "--heatmap") == 0) heat = true;
+        if (strcmp(argv[i], "--sprites") == 0) sprites = true;
+        if (strcmp(argv[i], "--overlay") == 0) overlay = true;
+        if (strcmp(argv[i], "--fixed-step") == 0) fixedStep = true;
+        if (strcmp(argv[i], "--share") == 0) share = "/bricks";
+        if (strncmp(argv[i], "--share=", 8) == 0) share = argv[i] + 8;
+        if (strncmp(argv[i], "--fps=", 6) == 0) fps = atof(argv[i] + 6);
+        if (strncmp(argv[i], "--buffers=", 10) == 0) buffers = atoi(argv[i] + 10);
+    }
+
     initializeApplication();
 
     const char * title = "Bricks @ LuGL";
-    Image image(scr_W, scr_H);
-    window = createWindow(title, scr_W, scr_H, image.data);
+    Image image(scr_W, scr_H, getSurfaceFormat() == PIXEL_BGRX ? PixelFormat::BGRX : PixelFormat::RGBA);
+    // The heatmap is shown on a copy, so the frame itself stays intact for the next one.
+    std::unique_ptr<Image> display;
+    if (heat) display.reset(new Image(scr_W, scr_H, image.format));
+    Image & presented = display ? *display : image;
+    // With a present thread, the window shows a surface of its own that only that thread writes.
+    std::unique_ptr<Image> surface;
+    if (buffers > 1 && canPresentFromThread()) surface.reset(new Image(scr_W, scr_H, image.format));
+    else if (buffers > 1) std::cerr << "This platform presents on the main thread, --buffers is ignored" << std::endl;
+    Image & shown = surface ? *surface : presented;
+    window = createWindow(title, scr_W, scr_H, (byte_t*)shown.data, shown.stride);
+    if (!window) {
+        // The platform printed why.
+        std::cerr << "Cannot create the window" << std::endl;
+        terminateApplication();
+        return 1;
+    }
+    std::unique_ptr<PresentThread> presenter;
+    if (surface) {
+        presenter.reset(new PresentThread(*surface, surfaceLock(window), buffers, [](Rect const* rects, int count) {
+            swapRects(window, rects, count);
+        }));
+    }
+    // External viewers and recorders read a copy of what is presented, updated where it changed.
+    SharedFramebuffer shared;
+    if (share && !shared.open(share, presented.width, presented.height, presented.format)) {
+        std::cerr << "Cannot share frames as " << share << std::endl;
+    }
+    // GUI widgets are cached in their own layer and only redrawn when they change.
+    gui.retain(image.format);
 
     setKeyboardCallback(window, keyboardEventCallback);
     setMouseButtonCallback(window, mouseButtonEventCallback);
@@ -42,10 +125,52 @@ int main(int argc, char* argv[]) {
 /////////////////////////////////////////////////////////////////////////////////////////////
 
     Game game(image);
+    // Effects keep moving while the game is paused or over.
+    Particles particles;
+    game.particles = &particles;
     game.init();
+    // Magenta pixels of the atlas are transparent.
+    SpriteAtlas atlas;
+    if (sprites) {
+        if (atlas.load("assets/atlas.ppm", image.format, color8{1.0f, 0.0f, 1.0f})) game.atlas = atlas.image.get();
+        else std::cerr << "Cannot load assets/atlas.ppm, drawing flat colors" << std::endl;
+    }
     bool game_on = true;
     bool game_pause = true;
 
+    // Game and GUI draw calls are recorded each frame, then executed by the renderer.
+    CommandBuffer commands;
+    TileRenderer tiler;
+    ScanlineRenderer scanlineRenderer;
+    IndexedImage indexedImage(scr_W, scr_H);
+    Renderer renderer;
+    if (tiled) renderer.tiler = &tiler;
+    if (scanline) renderer.scanline = &scanlineRenderer;
+    if (indexed) {
+        renderer.indexed = &indexedImage;
+        commands.indexed = &indexedImage;
+    }
+    Heatmap heatmap(scr_W, scr_H);
+    if (heat) {
+        renderer.heatmap = &heatmap;
+        commands.heatmap = &heatmap;
+    }
+    int frame = 0;
+
+    // Frames are presented at fixed deadlines, the main thread sleeps in between.
+    FramePacer pacer(fps);
+
+    // The scene alone is scaled, GUI text stays at window resolution.
+    // Its budget is the pacing period, against the time frames are busy rather than paced.
+    ResolutionController resolution(pacer.period > 0.0 ? pacer.period : 1.0f / 60.0f);
+    ScaledScene scene;
+    ScrollingScene scrollingScene;
+
+    // Objects drawn and culled over the run, printed at exit to check culling pays off.
+    DrawCounts drawCounts;
+    int64_t widgetsDrawn = 0;
+    int64_t widgetsCulled = 0;
+
     SETUP_FPS();
     Timer t;
     while (!windowShouldClose(window)) {
@@ -54,10 +179,29 @@ int main(int argc, char* argv[]) {
 ////////////// R E N D E R   L O O P
 /////////////////////////////////////////////////////////////////////////////////////////////
 
-        // Clear framebuffer.
-        image.fill(colorf{0, 0, 0});
+        // Time the game moves on by this frame.
+        float deltaTime = fixedStep ? 1.0f / 60.0f : t.deltaTime();
 
-        game.draw();
+        commands.record(image);
+        game.counts = {};
+        if (heat) heatmap.clear();
+
+        // Set when the whole framebuffer moved and must be presented.
+        bool scrolled = false;
+        if (dynres) {
+            scene.draw(image, game, resolution.update(pacer.busy));
+        }
+        else if (scrolling) {
+            scrolled = scrollingScene.draw(image, game, renderer);
+        }
+        else {
+            // Clear what was drawn last frame, the rest of the framebuffer is still black.
+            image.clearDirty(color8{0.0f, 0.0f, 0.0f});
+            game.draw();
+        }
+        particles.tick(deltaTime, game.player.gravity);
+        particles.draw(image, game.camera());
+        if (overlay) game.drawOverlay(game.target(image, 1));
 
         gui.text(image, "!!Bricks!!");
         gui.text(image, ">> Press A or D to jump <<");
@@ -82,7 +226,7 @@ int main(int argc, char* argv[]) {
                 else if (isKeyDown(window, KEY_D))
                     command = UserCommand::JumpRight;
 
-                if (game.tick(command, t.deltaTime())) {
+                if (game.tick(command, deltaTime)) {
                     game_on = false;
                     game_pause = true;
                     if (game.score > max_score) {
@@ -99,17 +243,76 @@ int main(int argc, char* argv[]) {
             }
         }
 
+        gui.composite(image);
+        int const frameWidgetsDrawn = gui.widgetsDrawn;
+        int const frameWidgetsCulled = gui.widgetsCulled;
+        widgetsDrawn += frameWidgetsDrawn;
+        widgetsCulled += frameWidgetsCulled;
         gui.tick();
 
-        UPDATE_FPS();
-        swapBuffer(window);
+        commands.stop();
+        // A skipped frame left the framebuffer as it was last presented, there is nothing to swap.
+        bool changed = renderer.execute(image, commands);
+        drawCounts += game.counts;
+
+        // An unchanged frame waits too, so paused and Game Over screens idle.
+        pacer.wait();
+        UPDATE_FPS(pacer.late);
+        if (changed) {
+            // Present only what was erased or drawn this frame.
+            Rect all = { 0, 0, presented.width, presented.height };
+            Rect const* rects = image.dirty.rects;
+            int count = image.dirty.count;
+            if (heat) {
+                presented.view().copy(image.view(), all);
+                heatmap.overlay(presented);
+                // About once a second.
+                if (++frame % 60 == 0) {
+                    std::cout << heatmap.summary(3)
+                              << " | levels " << game.counts.levelsDrawn << " drawn, " << game.counts.levelsCulled << " culled"
+                              << ", colliders " << game.counts.collidersDrawn << " drawn, " << game.counts.collidersCulled << " culled"
+                              << ", widgets " << frameWidgetsDrawn << " drawn, " << frameWidgetsCulled << " culled" << std::endl;
+                }
+            }
+            if (heat || scrolled) {
+                rects = &all;
+                count = 1;
+            }
+            if (presenter) presenter->submit(presented, rects, count);
+            else swapRects(window, rects, count);
+            shared.publish(presented, rects, count);
+        }
         pollEvent();
     }
 
+    std::cout << "Frames presented: " << renderer.executed
+              << ", skipped as unchanged: " << renderer.skipped
+              << ", last frame hash: " << std::hex << renderer.frameHash() << std::dec << std::endl;
+    std::cout << "Culling: levels " << drawCounts.levelsDrawn << " drawn, " << drawCounts.levelsCulled << " culled"
+              << ", colliders " << drawCounts.collidersDrawn << " drawn, " << drawCounts.collidersCulled << " culled"
+              << ", widgets " << widgetsDrawn << " drawn, " << widgetsCulled << " culled" << std::endl;
+    std::cout << pacer.summary() << std::endl;
+    if (presenter) {
+        presenter->stop();
+        std::cout << presenter->summary() << std::endl;
+    }
+
+    shared.close();
     terminateApplication();
     return 0;
 }
 
+// Present rects of the window surface.
+void swapRects(AppWindow *window, Rect const* rects, int count) {
+    Region regions[DirtyRegion::capacity];
+    count = std::min(count, DirtyRegion::capacity);
+    for (int i = 0; i < count; ++i) {
+        auto const& r = rects[i];
+        regions[i] = { r.x0, r.y0, r.x1 - r.x0, r.y1 - r.y0 };
+    }
+    swapBufferRegions(window, regions, count);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 ////////////// I N P U T   C A L L B A C K S
 /////////////////////////////////////////////////////////////////////////////////////////////
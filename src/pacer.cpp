@@ -0,0 +1,86 @@
+#include <thread>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include "pacer.h"
+
+// Sleep margin bounds in seconds. Sleeps on an idle system wake up well inside the minimum,
+// the margin grows to cover oversleeping timers, e.g. 15.6 ms ticks on Windows.
+constexpr double __min_margin = 0.0005;
+constexpr double __max_margin = 0.02;
+// The margin moves a tenth of the way to an oversleep times the headroom when that is
+// larger, so one preempted sleep does not turn the next frames into spins, and decays back down.
+constexpr double __margin_headroom = 1.5;
+constexpr double __margin_rise = 0.1;
+constexpr double __margin_decay = 0.95;
+
+static double seconds(FramePacer::Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+FramePacer::FramePacer(double rate) {
+    period = rate > 0.0 ? 1.0 / rate : 0.0;
+    margin = 0.002;
+    deadline = last = Clock::now();
+}
+
+bool FramePacer::wait() {
+    auto start = Clock::now();
+    busy = seconds(start - last);
+    ++frames;
+
+    bool onTime = true;
+    if (period > 0.0) {
+        deadline += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(period));
+        if (start >= deadline) {
+            onTime = false;
+            ++late;
+            worstLate = std::max(worstLate, seconds(start - deadline));
+            deadline = start;
+        }
+        else {
+            // Coarse sleep up to the margin, the OS may wake us later than asked.
+            auto wake = deadline - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(margin));
+            if (wake > start) {
+                std::this_thread::sleep_until(wake);
+                auto woke = Clock::now();
+                double over = seconds(woke - wake);
+                slept += seconds(woke - start);
+                double wanted = over * __margin_headroom;
+                if (wanted > margin) margin = std::min(margin + (wanted - margin) * __margin_rise, __max_margin);
+                else margin = std::max(margin * __margin_decay, __min_margin);
+            }
+            // Spin the rest for precision.
+            auto spin = Clock::now();
+            while (Clock::now() < deadline) std::this_thread::yield();
+            spun += seconds(Clock::now() - spin);
+        }
+    }
+
+    auto now = Clock::now();
+    if (frames > 1 && period > 0.0) {
+        double deviation = std::fabs(seconds(now - last) - period);
+        sumSquares += deviation * deviation;
+        maxDeviation = std::max(maxDeviation, deviation);
+        ++intervals;
+    }
+    last = now;
+    return onTime;
+}
+
+double FramePacer::jitter() const {
+    return intervals ? std::sqrt(sumSquares / intervals) : 0.0;
+}
+
+std::string FramePacer::summary() const {
+    char line[256];
+    if (period <= 0.0) {
+        snprintf(line, sizeof(line), "Pacing: off, %lld frames", (long long)frames);
+    }
+    else {
+        snprintf(line, sizeof(line),
+            "Pacing: %.1f Hz, %lld frames, %lld late (worst %.3f ms), jitter %.3f ms rms / %.3f ms worst, %.1f s slept, %.3f s spun",
+            1.0 / period, (long long)frames, (long long)late, worstLate * 1e3, jitter() * 1e3, maxDeviation * 1e3, slept, spun);
+    }
+    return line;
+}
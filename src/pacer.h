@@ -0,0 +1,54 @@
+#ifndef _PACER_H
+#define _PACER_H
+
+#include <chrono>
+#include <string>
+#include <cstdint>
+
+/**
+ * Holds frames to a target rate instead of running them back to back.
+ * - wait() returns at the frame's deadline, one period after the last one. It sleeps until
+ *   a margin before it and spins the rest, the margin follows how late sleeps wake up.
+ * - A frame that is still busy at its deadline is late: wait returns right away and the
+ *   following deadlines start from now, so late frames are not caught up in a burst.
+ * - Jitter is how far the time between two wait() returns is from the period.
+ * - A rate of 0 leaves frames unpaced, wait only takes the statistics.
+ */
+struct FramePacer {
+    using Clock = std::chrono::steady_clock;
+
+    // Seconds between deadlines, 0 when unpaced.
+    double period;
+
+    // Frames waited for, and those of them that were late.
+    int64_t frames = 0;
+    int64_t late = 0;
+    // Worst time a late frame was still busy past its deadline, in seconds.
+    double worstLate = 0.0;
+    // Time the last frame was busy before wait, in seconds, what the frame cost without pacing.
+    double busy = 0.0;
+
+    explicit FramePacer(double rate);
+
+    // Wait for the next deadline, returns false if the frame was late.
+    bool wait();
+
+    // Root mean square and largest deviation of frame intervals from the period, in seconds.
+    double jitter() const;
+    double worstJitter() const { return maxDeviation; }
+    // One line of the statistics above, with CPU time spent spinning.
+    std::string summary() const;
+
+private:
+    Clock::time_point deadline;
+    Clock::time_point last;
+    // Sleeps end this long before the deadline, the rest is spun.
+    double margin;
+    double sumSquares = 0.0;
+    double maxDeviation = 0.0;
+    int64_t intervals = 0;
+    double spun = 0.0;
+    double slept = 0.0;
+};
+
+#endif
@@ -0,0 +1,188 @@
+#include "particles.h"
+#include <algorithm>
+#include <climits>
+#include "span.h"
+#include "command.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PARTICLES_X86
+#include <immintrin.h>
+#endif
+
+// As in span.cpp, wider kernels are compiled per function and picked by the bound span tier.
+#if defined(__GNUC__) || defined(__clang__)
+#define PARTICLES_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PARTICLES_TARGET(isa)
+#endif
+
+// Attribute arrays of the particles integrated by one call.
+struct ParticleArrays {
+    float *x, *y, *vx, *vy, *life;
+};
+
+// Velocity first, then position, the same order in every kernel so all tiers give equal results.
+// (ax, ay) is the velocity gained per step, gravity * dt.
+static void integrateScalar(ParticleArrays const& p, int begin, int end, float ax, float ay, float dt) {
+    for (int i = begin; i < end; ++i) {
+        p.vx[i] = p.vx[i] + ax;
+        p.vy[i] = p.vy[i] + ay;
+        p.x[i] = p.x[i] + p.vx[i] * dt;
+        p.y[i] = p.y[i] + p.vy[i] * dt;
+        p.life[i] = p.life[i] - dt;
+    }
+}
+
+#if defined(PARTICLES_X86)
+
+PARTICLES_TARGET("sse2")
+static int integrateSSE2(ParticleArrays const& p, int count, float ax_, float ay_, float dt) {
+    __m128 t = _mm_set1_ps(dt);
+    __m128 ax = _mm_set1_ps(ax_);
+    __m128 ay = _mm_set1_ps(ay_);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_add_ps(_mm_loadu_ps(p.vx + i), ax);
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(p.vy + i), ay);
+        _mm_storeu_ps(p.vx + i, vx);
+        _mm_storeu_ps(p.vy + i, vy);
+        _mm_storeu_ps(p.x + i, _mm_add_ps(_mm_loadu_ps(p.x + i), _mm_mul_ps(vx, t)));
+        _mm_storeu_ps(p.y + i, _mm_add_ps(_mm_loadu_ps(p.y + i), _mm_mul_ps(vy, t)));
+        _mm_storeu_ps(p.life + i, _mm_sub_ps(_mm_loadu_ps(p.life + i), t));
+    }
+    return i;
+}
+
+PARTICLES_TARGET("avx2")
+static int integrateAVX2(ParticleArrays const& p, int count, float ax_, float ay_, float dt) {
+    __m256 t = _mm256_set1_ps(dt);
+    __m256 ax = _mm256_set1_ps(ax_);
+    __m256 ay = _mm256_set1_ps(ay_);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 vx = _mm256_add_ps(_mm256_loadu_ps(p.vx + i), ax);
+        __m256 vy = _mm256_add_ps(_mm256_loadu_ps(p.vy + i), ay);
+        _mm256_storeu_ps(p.vx + i, vx);
+        _mm256_storeu_ps(p.vy + i, vy);
+        _mm256_storeu_ps(p.x + i, _mm256_add_ps(_mm256_loadu_ps(p.x + i), _mm256_mul_ps(vx, t)));
+        _mm256_storeu_ps(p.y + i, _mm256_add_ps(_mm256_loadu_ps(p.y + i), _mm256_mul_ps(vy, t)));
+        _mm256_storeu_ps(p.life + i, _mm256_sub_ps(_mm256_loadu_ps(p.life + i), t));
+    }
+    return i;
+}
+
+#endif // PARTICLES_X86
+
+// Write count particles as Size x Size rects on v, which covers the whole layer. Returns what was written.
+template<int Size>
+static Rect splat(ImageView const& v, float const* x, float const* y, uint32_t const* color, int count, int camera) {
+    // Scene y of the top row, as in the scene's targets at factor 1. Only particles at or above
+    // the origin of x and of the bottom row can be on the layer, so truncating is flooring.
+    float bottom = (float)camera;
+    int top = v.height - 1 + camera;
+    unsigned maxX = (unsigned)(v.width - Size);
+    unsigned maxY = (unsigned)(v.height - Size);
+    int x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
+    for (int i = 0; i < count; ++i) {
+        if (x[i] < 0.0f || y[i] < bottom) continue;
+        int px = (int)x[i];
+        int py = top - (int)y[i];
+        if ((unsigned)px > maxX || (unsigned)py > maxY) continue;
+        auto *d = v.data + py * v.stride + px;
+        for (int r = 0; r < Size; ++r, d += v.stride) {
+            for (int c = 0; c < Size; ++c) d[c] = color[i];
+        }
+        x0 = std::min(x0, px);
+        y0 = std::min(y0, py);
+        x1 = std::max(x1, px + Size);
+        y1 = std::max(y1, py + Size);
+    }
+    return x0 < x1 ? Rect{ x0, y0, x1, y1 } : Rect{};
+}
+
+Particles::Particles()
+    : x(capacity)
+    , y(capacity)
+    , vx(capacity)
+    , vy(capacity)
+    , life(capacity)
+    , color(capacity) {}
+
+void Particles::clear() {
+    if (count) ++generation;
+    count = 0;
+}
+
+float Particles::random() {
+    // xorshift32, separate from rand() so effects leave the game's levels as they were.
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return (float)(seed >> 8) / (float)(1 << 24);
+}
+
+void Particles::emit(float2 const& position, float2 const& velocity, float spread, int n, float lifetime, Image::dataType pixel) {
+    n = std::min(n, capacity - count);
+    if (n <= 0) return;
+    for (int i = count; i < count + n; ++i) {
+        x[i] = position.x;
+        y[i] = position.y;
+        vx[i] = velocity.x + (random() * 2.0f - 1.0f) * spread;
+        vy[i] = velocity.y + (random() * 2.0f - 1.0f) * spread;
+        life[i] = lifetime * (0.5f + random());
+        color[i] = pixel;
+    }
+    count += n;
+    ++generation;
+}
+
+void Particles::tick(float deltaTime, float2 const& gravity) {
+    if (!count) return;
+    float ax = gravity.x * deltaTime;
+    float ay = gravity.y * deltaTime;
+    ParticleArrays p = { x.data(), y.data(), vx.data(), vy.data(), life.data() };
+    int done = 0;
+#if defined(PARTICLES_X86)
+    if (spanTier() >= SimdTier::AVX2) done = integrateAVX2(p, count, ax, ay, deltaTime);
+    else if (spanTier() >= SimdTier::SSE2) done = integrateSSE2(p, count, ax, ay, deltaTime);
+#endif
+    integrateScalar(p, done, count, ax, ay, deltaTime);
+
+    // Swap-remove expired particles, the last live one takes each free slot.
+    for (int i = 0; i < count;) {
+        if (life[i] > 0.0f) {
+            ++i;
+            continue;
+        }
+        --count;
+        x[i] = x[count];
+        y[i] = y[count];
+        vx[i] = vx[count];
+        vy[i] = vy[count];
+        life[i] = life[count];
+        color[i] = color[count];
+    }
+    ++generation;
+}
+
+void Particles::draw(Image & image, int camera, int size) {
+    if (!layer || layer->width != image.width || layer->height != image.height || layer->format != image.format) {
+        layer.reset(new Image(image.width, image.height, image.format));
+        drawn = {};
+    }
+    if (!count && drawn.empty()) return;
+
+    auto v = layer->view();
+    v.fillRect(drawn, 0);
+
+    switch (std::min(std::max(size, 1), 4)) {
+    case 1: drawn = splat<1>(v, x.data(), y.data(), color.data(), count, camera); break;
+    case 2: drawn = splat<2>(v, x.data(), y.data(), color.data(), count, camera); break;
+    case 3: drawn = splat<3>(v, x.data(), y.data(), color.data(), count, camera); break;
+    default: drawn = splat<4>(v, x.data(), y.data(), color.data(), count, camera); break;
+    }
+    if (drawn.empty()) return;
+
+    DrawSite site("particles");
+    image.drawLayer(*layer, drawn, generation);
+}
@@ -0,0 +1,57 @@
+#ifndef _PARTICLES_H
+#define _PARTICLES_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "macro.h"
+#include "image.h"
+
+/**
+ * Short-lived points for effects, one array per attribute.
+ * - Arrays are allocated once at capacity, particles emitted while full are dropped.
+ * - tick moves whole SIMD registers of particles at a time, then swap-removes the dead ones,
+ *   so particles do not keep their order.
+ * - Positions and velocities are in scene units, y goes up, as in Player.
+ */
+struct Particles {
+    static constexpr int capacity = 131072;
+
+    std::vector<float> x, y;
+    std::vector<float> vx, vy;
+    // Seconds left to live.
+    std::vector<float> life;
+    std::vector<Image::dataType> color;
+    int count = 0;
+
+    Particles();
+
+    void clear();
+    /**
+     * Emit n particles at position, moving at velocity plus up to spread in any direction.
+     * - Each lives between 0.5 and 1.5 times lifetime seconds.
+     * - color is packed in the format of the image they are drawn on.
+     */
+    void emit(float2 const& position, float2 const& velocity, float spread, int n, float lifetime, Image::dataType color);
+    // Advance by deltaTime under gravity, stepped like Player::tick, then drop expired particles.
+    void tick(float deltaTime, float2 const& gravity);
+
+    /**
+     * Splat every particle as a size x size rect on image, in one layer draw call, size is 1 to 4.
+     * - Scene y is moved down by camera pixels and flipped over image's height, as the scene is at factor 1.
+     * - Particles are drawn into a layer of image's size first, which only keeps what changed since last draw.
+     */
+    void draw(Image & image, int camera, int size = 2);
+
+private:
+    float random();
+
+    uint32_t seed = 0x9E3779B9u;
+    // Bumped whenever particles change, the layer's content key.
+    uint64_t generation = 0;
+    std::unique_ptr<Image> layer;
+    // Pixels of the layer splatted by the last draw.
+    Rect drawn = {};
+};
+
+#endif
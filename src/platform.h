@@ -8,6 +8,7 @@
 #include <cassert>
 #include <cstdlib>
 #include <string>
+#include <mutex>
 
 #define __unused_variable(var) (void(var))
 
@@ -17,6 +18,7 @@ namespace LuGL
     typedef struct APPWINDOW AppWindow;
     typedef enum {KEY_A, KEY_D, KEY_S, KEY_W, KEY_SPACE, KEY_ESCAPE, KEY_I, KEY_O, KEY_P, KEY_NUM} KEY_CODE;
     typedef enum {BUTTON_L, BUTTON_R, BUTTON_NUM} MOUSE_BUTTON;
+    typedef enum {PIXEL_RGBA, PIXEL_BGRX} PIXEL_FORMAT;
 
     struct TIME {
         int year;
@@ -30,6 +32,15 @@ namespace LuGL
     };
     typedef struct TIME Time;
 
+    // Surface rectangle in pixels, origin at the top-left corner.
+    struct REGION {
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+    typedef struct REGION Region;
+
 
     /**
      *  application
@@ -40,11 +51,22 @@ namespace LuGL
 
     /**
      *  window
+     *  - surface_buffer holds height rows of packed 32-bit pixels in getSurfaceFormat() order,
+     *    it is presented as is without conversion.
+     *  - rows are surface_stride pixels apart, 0 means width.
      */
-    AppWindow *createWindow(const char *title, long width, long height, byte_t *surface_buffer);
+    PIXEL_FORMAT getSurfaceFormat();
+    AppWindow *createWindow(const char *title, long width, long height, byte_t *surface_buffer, long surface_stride = 0);
     void destroyWindow(AppWindow *window);
     void swapBuffer(AppWindow *window);
+    // Like swapBuffer, but only the given surface regions are uploaded to the window.
+    void swapBufferRegions(AppWindow *window, const Region *regions, int count);
     bool windowShouldClose(AppWindow *window);
+    // True when swapBuffer and swapBufferRegions may be called from another thread while pollEvent runs.
+    bool canPresentFromThread();
+    // Held by the backend while it reads the surface, for presents and for redraws of its own, e.g. on Expose.
+    // A thread that writes the surface while pollEvent runs takes it around those writes.
+    std::mutex &surfaceLock(AppWindow *window);
     void setWindowTitle(AppWindow *window, const char *title);
 
     /**
@@ -0,0 +1,128 @@
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include "present.h"
+#include "span.h"
+
+// Copy rects of src to dst, both of the same size.
+static void copyRects(Image & dst, Image const& src, DirtyRegion const& region) {
+    for (int i = 0; i < region.count; ++i) {
+        Rect r = region.rects[i];
+        r.x0 = std::max(r.x0, 0);
+        r.y0 = std::max(r.y0, 0);
+        r.x1 = std::min(r.x1, dst.width);
+        r.y1 = std::min(r.y1, dst.height);
+        if (r.empty()) continue;
+        dst.view().copy(src.view(), r);
+    }
+}
+
+PresentThread::PresentThread(Image & surface_, std::mutex & surfaceLock_, int buffers_, Present present_)
+    : surface(surface_)
+    , surfaceLock(surfaceLock_)
+    , present(std::move(present_))
+    , count(std::min(std::max(buffers_, 2), 3)) {
+    for (int i = 0; i < count; ++i) {
+        buffers[i].image.reset(new Image(surface.width, surface.height, surface.format));
+        // Nothing is in any buffer yet.
+        buffers[i].missing.add({ 0, 0, surface.width, surface.height });
+    }
+    idle.store(((1u << count) - 1) & ~(1u << back), std::memory_order_relaxed);
+    // The window starts out blank, the first frame is presented whole.
+    carry.add({ 0, 0, surface.width, surface.height });
+    thread = std::thread(&PresentThread::run, this);
+}
+
+PresentThread::~PresentThread() {
+    stop();
+}
+
+void PresentThread::stop() {
+    if (!thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+// A buffer to draw the next frame into, waits for the present thread when there is none.
+int PresentThread::acquire() {
+    unsigned mask = idle.load(std::memory_order_acquire);
+    if (!mask) {
+        ++stalls;
+        std::unique_lock<std::mutex> lock(mutex);
+        freed.wait(lock, [&] { return (mask = idle.load(std::memory_order_acquire)) != 0; });
+    }
+    int buffer = 0;
+    while (!(mask & (1u << buffer))) ++buffer;
+    idle.fetch_and(~(1u << buffer), std::memory_order_relaxed);
+    return buffer;
+}
+
+void PresentThread::submit(Image const& image, Rect const* rects, int n) {
+    for (int i = 0; i < count; ++i) {
+        for (int j = 0; j < n; ++j) buffers[i].missing.add(rects[j]);
+    }
+
+    Buffer & b = buffers[back];
+    copyRects(*b.image, image, b.missing);
+    b.missing.clear();
+    b.damage = carry;
+    for (int j = 0; j < n; ++j) b.damage.add(rects[j]);
+    carry.clear();
+
+    // Take back a frame the present thread has not picked up before handing over this one.
+    // Its changes are presented with this frame, which holds them too.
+    int previous = ready.exchange(-1, std::memory_order_acq_rel);
+    if (previous >= 0) {
+        ++drops;
+        DirtyRegion const& dropped = buffers[previous].damage;
+        for (int j = 0; j < dropped.count; ++j) b.damage.add(dropped.rects[j]);
+    }
+    ready.store(back, std::memory_order_release);
+    // The lock only keeps the wakeup from slipping in between the present thread's check and its wait.
+    { std::lock_guard<std::mutex> lock(mutex); }
+    wake.notify_one();
+
+    back = previous >= 0 ? previous : acquire();
+}
+
+void PresentThread::run() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return quit || ready.load(std::memory_order_acquire) >= 0; });
+        }
+        int next = ready.exchange(-1, std::memory_order_acq_rel);
+        if (next < 0) {
+            // Quitting with every frame presented.
+            return;
+        }
+        if (front >= 0) {
+            idle.fetch_or(1u << front, std::memory_order_release);
+            { std::lock_guard<std::mutex> lock(mutex); }
+            freed.notify_one();
+        }
+        front = next;
+
+        auto start = std::chrono::steady_clock::now();
+        Buffer const& b = buffers[front];
+        {
+            std::lock_guard<std::mutex> lock(surfaceLock);
+            copyRects(surface, *b.image, b.damage);
+        }
+        present(b.damage.rects, b.damage.count);
+        presentSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        presents.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::string PresentThread::summary() const {
+    char line[256];
+    int64_t n = presented();
+    snprintf(line, sizeof(line), "Present thread: %d buffers, %lld frames presented, %lld dropped, %lld submits waited, %.3f ms per present",
+        count, (long long)n, (long long)drops, (long long)stalls, n ? presentSeconds * 1e3 / n : 0.0);
+    return line;
+}
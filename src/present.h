@@ -0,0 +1,91 @@
+#ifndef _PRESENT_H
+#define _PRESENT_H
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <functional>
+#include <condition_variable>
+#include "image.h"
+
+/**
+ * Presents frames on a thread of its own, through a swap chain of two or three buffers.
+ * - submit copies what changed into the main thread's back buffer and hands it over with an
+ *   atomic exchange. The present thread copies the frame's changes into surface and calls
+ *   present, while the main thread goes on drawing the next frame.
+ * - surface is only written by the present thread, under surfaceLock, which the window
+ *   holds when it reads surface itself, e.g. to redraw after an Expose. The window never
+ *   shows a frame being drawn.
+ * - A frame not yet picked up when the next one is submitted is taken back and dropped,
+ *   the newer frame is handed over with the changes of both.
+ * - With three buffers submit never waits. With two, it waits when the present thread is
+ *   still presenting the frame before, which holds the other buffer.
+ */
+struct PresentThread {
+    // Upload rects of surface to the window, in memory rows.
+    using Present = std::function<void(Rect const* rects, int count)>;
+
+    PresentThread(Image & surface, std::mutex & surfaceLock, int buffers, Present present);
+    ~PresentThread();
+    PresentThread(PresentThread const&) = delete;
+    PresentThread & operator=(PresentThread const&) = delete;
+
+    // Hand over image, which changed only inside count rects since the last submit.
+    void submit(Image const& image, Rect const* rects, int count);
+    // Present what was submitted and end the thread, before the window goes away. No submit may follow.
+    void stop();
+
+    // Frames presented, dropped for a newer one, and submits that waited for a buffer.
+    int64_t presented() const { return presents.load(std::memory_order_relaxed); }
+    int64_t dropped() const { return drops; }
+    int64_t stalled() const { return stalls; }
+    // The numbers above and the average time the present thread took per frame, after stop.
+    std::string summary() const;
+
+private:
+    struct Buffer {
+        std::unique_ptr<Image> image;
+        // What changed since the frame submitted before, set before the buffer is handed over.
+        DirtyRegion damage;
+        // What the buffer misses of the latest frame, main thread only.
+        DirtyRegion missing;
+    };
+
+    void run();
+    int acquire();
+
+    Image & surface;
+    std::mutex & surfaceLock;
+    Present present;
+    int count;
+    Buffer buffers[3];
+
+    // Main thread.
+    int back = 0;
+    // Changes handed over with the next frame besides its own, the whole surface at first.
+    DirtyRegion carry;
+    int64_t drops = 0;
+    int64_t stalls = 0;
+
+    // Present thread.
+    int front = -1;
+    double presentSeconds = 0.0;
+
+    // Handoff: the newest submitted frame, -1 when there is none, and a bit per buffer neither
+    // thread holds. Only the present thread sets bits and only the main thread clears them.
+    std::atomic<int> ready{-1};
+    std::atomic<unsigned> idle{0};
+    std::atomic<int64_t> presents{0};
+
+    // Only to let either thread sleep, the present thread while there is no frame and the
+    // main thread while there is no free buffer.
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable freed;
+    bool quit = false;
+    std::thread thread;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "renderer.h"
+
+// How many batches back a command may move, bounds batching cost per command.
+int const __batch_window = 64;
+
+Renderer::Renderer() {
+    batches.reserve(CommandBuffer::capacity);
+    next.reserve(CommandBuffer::capacity);
+}
+
+bool Renderer::execute(Image & image, CommandBuffer const& buffer) {
+    // A flushed buffer only holds the tail of its frame, it can neither be skipped nor matched later.
+    uint64_t hash = buffer.hash();
+    if (!buffer.flushed && hasLast && hash == lastHash) {
+        ++skipped;
+        return false;
+    }
+    lastHash = hash;
+    hasLast = !buffer.flushed;
+    if (heatmap) heatmap->accumulate(buffer);
+
+    if (indexed) {
+        indexed->execute(buffer);
+        DirtyRegion all;
+        if (scrolled) all.add({ 0, 0, image.width, image.height });
+        indexed->present(image.view(), scrolled ? all : image.dirty);
+        scrolled = false;
+    }
+    else if (tiler) {
+        tiler->execute(image, buffer);
+    }
+    else if (scanline) {
+        scanline->execute(image.view(), buffer);
+    }
+    else {
+        executeBatched(image, buffer);
+    }
+    ++executed;
+    return true;
+}
+
+void Renderer::scroll(Image & image, int dy) {
+    if (indexed) indexed->view().scroll(dy);
+    else image.view().scroll(dy);
+    hasLast = false;
+    scrolled = true;
+}
+
+static bool overlaps(Rect const& a, Rect const& b) {
+    return a.x0 < b.x1 && b.x0 < a.x1
+        && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+void Renderer::executeBatched(Image & image, CommandBuffer const& buffer) {
+    auto view = image.view();
+    Rect clip = view.bounds();
+    auto const& commands = buffer.commands;
+    batches.clear();
+    next.assign(commands.size(), -1);
+
+    for (int i = 0; i < (int)commands.size(); ++i) {
+        auto const& command = commands[i];
+        if (!overlaps(command.bounds, clip)) continue;
+
+        // Walk back to the latest batch of the same state that nothing in between overlaps.
+        int target = -1;
+        int stop = std::max((int)batches.size() - __batch_window, 0);
+        for (int b = (int)batches.size() - 1; b >= stop; --b) {
+            auto const& batch = batches[b];
+            if (batch.type == command.type && batch.pixel == command.pixel) {
+                target = b;
+                break;
+            }
+            if (overlaps(batch.bounds, command.bounds)) break;
+        }
+
+        if (target < 0) {
+            batches.push_back({ command.type, command.pixel, command.bounds, i, i });
+            continue;
+        }
+        auto & batch = batches[target];
+        next[batch.tail] = i;
+        batch.tail = i;
+        batch.bounds = {
+            std::min(batch.bounds.x0, command.bounds.x0), std::min(batch.bounds.y0, command.bounds.y0),
+            std::max(batch.bounds.x1, command.bounds.x1), std::max(batch.bounds.y1, command.bounds.y1),
+        };
+    }
+
+    for (auto const& batch : batches) {
+        for (int i = batch.head; i >= 0; i = next[i]) {
+            buffer.execute(view, commands[i]);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef _RENDERER_H
+#define _RENDERER_H
+
+#include <vector>
+#include <cstdint>
+#include "image.h"
+#include "command.h"
+#include "tile.h"
+#include "indexed.h"
+#include "scanline.h"
+#include "heatmap.h"
+
+/**
+ * Executes recorded frames into an image.
+ * - Commands are regrouped into batches of equal type and color. A command only
+ *   moves ahead of commands it does not overlap, so pixels match recording order.
+ * - Commands outside the image are dropped before batching.
+ * - A frame hashing equal to the last executed one is skipped, the image already
+ *   holds its pixels as long as nothing else wrote to it in between. Callers presenting
+ *   every executed frame need not present a skipped one either.
+ * - With tiler set, frames are rasterized in parallel tiles instead of batches.
+ * - With scanline set, rect fills are resolved per band so each pixel is written once.
+ * - With indexed set, frames are executed into indexed instead and its pixels are
+ *   expanded into the image's dirty region, tiler and scanline are then unused.
+ * - With heatmap set, the writes of every executed frame are counted into it.
+ */
+struct Renderer {
+    TileRenderer *tiler = nullptr;
+    ScanlineRenderer *scanline = nullptr;
+    IndexedImage *indexed = nullptr;
+    Heatmap *heatmap = nullptr;
+
+    // Frames executed and skipped as unchanged.
+    int executed = 0;
+    int skipped = 0;
+    // Hash of the recorded commands of the last frame, executed or skipped.
+    uint64_t frameHash() const { return lastHash; }
+
+    Renderer();
+
+    // Returns false if the frame was skipped.
+    bool execute(Image & image, CommandBuffer const& buffer);
+    /**
+     * Move the pixels of image down by dy rows right away, ahead of the frame being recorded.
+     * - The next frame is always executed, image no longer holds the last one.
+     * - With indexed set, indexed is moved instead and the next frame is expanded into all of image.
+     *   A dy of 0 moves nothing, the next frame is still expanded whole.
+     */
+    void scroll(Image & image, int dy);
+
+private:
+    void executeBatched(Image & image, CommandBuffer const& buffer);
+
+    struct Batch {
+        CommandType type;
+        Image::dataType pixel;
+        Rect bounds;
+        int head, tail;
+    };
+    std::vector<Batch> batches;
+    std::vector<int> next;
+
+    uint64_t lastHash = 0;
+    bool hasLast = false;
+    bool scrolled = false;
+};
+
+#endif
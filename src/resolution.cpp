@@ -0,0 +1,63 @@
+#include "resolution.h"
+
+// Weight of the newest frame time in the average.
+float const __frame_smoothing = 0.1f;
+// Frames a new factor is kept before the next change.
+int const __factor_hold = 30;
+// Step down only if the estimated frame time at the finer factor is under this share of the budget.
+float const __step_down_margin = 0.8f;
+
+ResolutionController::ResolutionController(float budget_)
+    : budget(budget_) {}
+
+int ResolutionController::update(float frameTime) {
+    average = average > 0.0f ? average + (frameTime - average) * __frame_smoothing : frameTime;
+    if (hold > 0) {
+        --hold;
+        return factor;
+    }
+
+    if (average > budget && factor < maxFactor) {
+        ++factor;
+    }
+    else if (factor > 1) {
+        float finer = (float)factor / (factor - 1);
+        if (average * finer * finer < budget * __step_down_margin) --factor;
+        else return factor;
+    }
+    else {
+        return factor;
+    }
+
+    hold = __factor_hold;
+    return factor;
+}
+
+void ScaledScene::draw(Image & image, Game const& game, int factor) {
+    auto & scene = scenes[factor - 1];
+    if (!scene) {
+        scene.reset(new Image((image.width + factor - 1) / factor, (image.height + factor - 1) / factor, image.format));
+    }
+
+    commands.record(*scene);
+    scene->clearDirty(color8{0.0f, 0.0f, 0.0f});
+    game.draw(*scene, factor);
+    commands.stop();
+    renderer.execute(*scene, commands);
+    // A flushed buffer only hashes the tail of the scene, such frames never match.
+    uint64_t key = commands.flushed ? fnv1a(&++flushes, sizeof(flushes)) : commands.hash();
+
+    // Restore the scene under what was drawn last frame, then upscale what the scene changed.
+    DrawSite site("upscale");
+    image.clearDirty(*scene, factor, key);
+    if (factor != lastFactor) {
+        image.drawUpscaled(*scene, factor, { 0, 0, image.width, image.height }, key);
+    }
+    else {
+        for (int i = 0; i < scene->dirty.count; ++i) {
+            auto const& r = scene->dirty.rects[i];
+            image.drawUpscaled(*scene, factor, { r.x0 * factor, r.y0 * factor, r.x1 * factor, r.y1 * factor }, key);
+        }
+    }
+    lastFactor = factor;
+}
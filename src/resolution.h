@@ -0,0 +1,53 @@
+#ifndef _RESOLUTION_H
+#define _RESOLUTION_H
+
+#include <memory>
+#include <cstdint>
+#include "image.h"
+#include "game.h"
+#include "command.h"
+#include "renderer.h"
+
+/**
+ * Picks how far below window resolution the scene is rendered to hold a frame budget.
+ * - The scene is drawn at window size / factor and upscaled, so its cost falls with factor^2.
+ * - Frame times are smoothed. The factor steps up while the average is over budget, and back
+ *   down once the average scaled to the finer factor still fits well inside the budget.
+ * - A new factor is held for some frames before the next change, so the average can settle.
+ */
+struct ResolutionController {
+    static constexpr int maxFactor = 4;
+
+    // Target frame time in seconds.
+    float budget;
+    int factor = 1;
+
+    explicit ResolutionController(float budget);
+
+    // Account the last frame time in seconds, returns the factor for the next frame.
+    int update(float frameTime);
+
+private:
+    float average = 0.0f;
+    int hold = 0;
+};
+
+/**
+ * Game scene drawn below window resolution and upscaled into the window image.
+ * - There is one scene image per factor, each keeps its own dirty region.
+ * - The scene is recorded and executed on its own, so an unchanged scene is not redrawn
+ *   and its upscale commands hash the same, letting the window frame be skipped too.
+ */
+struct ScaledScene {
+    // Draw game into the scene image for factor, and upscale what changed into image.
+    void draw(Image & image, Game const& game, int factor);
+
+private:
+    std::unique_ptr<Image> scenes[ResolutionController::maxFactor];
+    CommandBuffer commands;
+    Renderer renderer;
+    int lastFactor = 0;
+    uint64_t flushes = 0;
+};
+
+#endif
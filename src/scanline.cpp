@@ -0,0 +1,100 @@
+#include "scanline.h"
+#include <algorithm>
+#include "span.h"
+
+ScanlineRenderer::ScanlineRenderer() {
+    shapes.reserve(CommandBuffer::capacity);
+    edges.reserve(CommandBuffer::capacity * 2);
+}
+
+void ScanlineRenderer::add(Rect const& r, uint32_t pixel, ImageView const& view) {
+    Rect b = view.bounds();
+    Rect c = {
+        std::max(r.x0, b.x0), std::max(r.y0, b.y0),
+        std::min(r.x1, b.x1), std::min(r.y1, b.y1),
+    };
+    if (!c.empty()) shapes.push_back({ c, pixel });
+}
+
+void ScanlineRenderer::execute(ImageView const& view, CommandBuffer const& buffer) {
+    written = 0;
+    shapes.clear();
+    for (auto const& command : buffer.commands) {
+        switch (command.type) {
+        case CommandType::FillRect:
+            add(command.bounds, command.pixel, view);
+            break;
+        case CommandType::OutlineRect: {
+            // The same four bands as ImageView::outline.
+            Rect r = { command.x, command.y, command.x1, command.y1 };
+            int t = command.scale;
+            add({ r.x0, r.y0, r.x1, r.y0 + t }, command.pixel, view);
+            add({ r.x0, r.y1 - t, r.x1, r.y1 }, command.pixel, view);
+            add({ r.x0, r.y0 + t, r.x0 + t, r.y1 - t }, command.pixel, view);
+            add({ r.x1 - t, r.y0 + t, r.x1, r.y1 - t }, command.pixel, view);
+            break;
+        }
+        default:
+            resolve(view);
+            buffer.execute(view, command);
+            break;
+        }
+    }
+    resolve(view);
+}
+
+void ScanlineRenderer::resolve(ImageView const& view) {
+    if (shapes.empty()) return;
+
+    edges.clear();
+    for (int i = 0; i < (int)shapes.size(); ++i) {
+        edges.push_back({ shapes[i].rect.y0, i, true });
+        edges.push_back({ shapes[i].rect.y1, i, false });
+    }
+    std::sort(edges.begin(), edges.end(), [](Edge const& a, Edge const& b) {
+        return a.y < b.y;
+    });
+
+    active.clear();
+    for (size_t e = 0; e < edges.size();) {
+        // Apply every edge on this row, the active set is then constant down to the next edge.
+        int y0 = edges[e].y;
+        for (; e < edges.size() && edges[e].y == y0; ++e) {
+            auto const& edge = edges[e];
+            auto at = std::lower_bound(active.begin(), active.end(), edge.shape);
+            if (edge.open) active.insert(at, edge.shape);
+            else active.erase(at);
+        }
+        if (e == edges.size() || active.empty()) continue;
+        int y1 = edges[e].y;
+
+        // Front-to-back, each shape takes what is still uncovered of its x range.
+        spans.clear();
+        gaps.assign(1, { view.x0, view.x0 + view.width, 0 });
+        for (auto it = active.rbegin(); it != active.rend() && !gaps.empty(); ++it) {
+            auto const& shape = shapes[*it];
+            int sx0 = shape.rect.x0;
+            int sx1 = shape.rect.x1;
+            remaining.clear();
+            for (auto const& gap : gaps) {
+                int x0 = std::max(gap.x0, sx0);
+                int x1 = std::min(gap.x1, sx1);
+                if (x0 >= x1) {
+                    remaining.push_back(gap);
+                    continue;
+                }
+                spans.push_back({ x0, x1, shape.pixel });
+                if (gap.x0 < x0) remaining.push_back({ gap.x0, x0, 0 });
+                if (x1 < gap.x1) remaining.push_back({ x1, gap.x1, 0 });
+            }
+            gaps.swap(remaining);
+        }
+
+        for (int y = y0; y < y1; ++y) {
+            auto row = view.row(y);
+            for (auto const& span : spans) fillSpan(row + span.x0, span.x1 - span.x0, span.pixel);
+        }
+        for (auto const& span : spans) written += (int64_t)(span.x1 - span.x0) * (y1 - y0);
+    }
+    shapes.clear();
+}
@@ -0,0 +1,51 @@
+#ifndef _SCANLINE_H
+#define _SCANLINE_H
+
+#include <vector>
+#include <cstdint>
+#include "image.h"
+#include "command.h"
+
+/**
+ * Zero-overdraw executor for frames made of axis-aligned rects.
+ * - Consecutive FillRect and OutlineRect commands are resolved together. Their y edges are
+ *   sorted into bands where the same rects are active, and each band is split front-to-back
+ *   into spans owned by the latest rect covering them.
+ * - Each covered pixel is written once, background fills recorded before the rects included.
+ * - Other commands end the run and execute as recorded, so pixels match recording order.
+ */
+struct ScanlineRenderer {
+    // Pixels written by rect runs in the last execute.
+    int64_t written = 0;
+
+    ScanlineRenderer();
+
+    void execute(ImageView const& view, CommandBuffer const& buffer);
+
+private:
+    void add(Rect const& r, uint32_t pixel, ImageView const& view);
+    void resolve(ImageView const& view);
+
+    struct Shape {
+        Rect rect;
+        uint32_t pixel;
+    };
+    struct Edge {
+        int y;
+        int shape;
+        bool open;
+    };
+    struct Span {
+        int x0, x1;
+        uint32_t pixel;
+    };
+    std::vector<Shape> shapes;
+    std::vector<Edge> edges;
+    // Shapes crossing the current band, in recording order.
+    std::vector<int> active;
+    // Uncovered x intervals while splitting a band, and the spans that cover it.
+    std::vector<Span> gaps, remaining;
+    std::vector<Span> spans;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#include "scroll.h"
+#include <algorithm>
+
+bool ScrollingScene::draw(Image & image, Game const& game, Renderer & renderer) {
+    SceneTarget target = game.target(image, 1);
+    int dy = target.camera - lastCamera;
+    bool whole = !drawn || dy < 0 || dy >= image.height;
+    lastCamera = target.camera;
+    drawn = true;
+
+    DirtyRegion previous = image.dirty;
+    image.dirty.clear();
+    if (whole) {
+        renderer.scroll(image, 0);
+        redraw(image, game, target, { 0, 0, image.width, image.height });
+    }
+    else {
+        if (dy > 0) {
+            renderer.scroll(image, dy);
+            scrolledRows += dy;
+            redraw(image, game, target, { 0, 0, image.width, dy });
+        }
+        // Last frame's player and GUI moved down with everything else. Merging reorders the region,
+        // sorting keeps the commands of an unchanged frame in the same order, so it hashes the same.
+        std::sort(previous.rects, previous.rects + previous.count, [](Rect const& a, Rect const& b) {
+            return a.y0 != b.y0 ? a.y0 < b.y0 : a.x0 < b.x0;
+        });
+        for (int i = 0; i < previous.count; ++i) {
+            auto const& r = previous.rects[i];
+            redraw(image, game, target, { r.x0, r.y0 + dy, r.x1, std::min(r.y1 + dy, image.height) });
+        }
+    }
+    // A moved image is presented whole, and what was redrawn moves with the scene from now on.
+    // Only what is drawn over the scene is kept to be redrawn under next frame.
+    if (whole || dy > 0) image.dirty.clear();
+    game.drawPlayer(target);
+    return whole || dy > 0;
+}
+
+void ScrollingScene::redraw(Image & image, Game const& game, SceneTarget target, Rect const& r) {
+    if (r.x0 >= r.x1 || r.y0 >= r.y1) return;
+    redrawnPixels += (int64_t)(r.x1 - r.x0) * (r.y1 - r.y0);
+    DrawSite site("scroll");
+    image.fillRect(r.x0, r.y0, r.x1, r.y1, image.pack(color8{0.0f, 0.0f, 0.0f}), false);
+    target.clip = r;
+    game.drawLevels(target);
+}
@@ -0,0 +1,34 @@
+#ifndef _SCROLL_H
+#define _SCROLL_H
+
+#include <cstdint>
+#include "image.h"
+#include "game.h"
+#include "renderer.h"
+
+/**
+ * Game scene drawn by scrolling the last frame instead of redrawing it.
+ * - The camera only moves up, so the last frame is moved down by the camera step
+ *   and only the rows scrolled in at the top are drawn anew.
+ * - What did not move with the scene last frame, the player and GUI, is still in the image's
+ *   dirty region. The scene is redrawn there, then the player is drawn on top.
+ * - Pixel work grows with the scroll speed instead of the window area, only the row moves touch every pixel.
+ * - A camera moving back or by a whole image redraws the scene everywhere.
+ */
+struct ScrollingScene {
+    // Rows moved and scene pixels drawn anew, summed over frames.
+    int64_t scrolledRows = 0;
+    int64_t redrawnPixels = 0;
+
+    // Draw game into image, moving it with renderer. Returns true if image moved, then all of it must be presented.
+    bool draw(Image & image, Game const& game, Renderer & renderer);
+
+private:
+    // Scene alone inside r, in memory rows.
+    void redraw(Image & image, Game const& game, SceneTarget target, Rect const& r);
+
+    int lastCamera = 0;
+    bool drawn = false;
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include <cstring>
+#include <cstdio>
+#include <new>
+#include "shared.h"
+#include "span.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SHARED_POSIX 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// The header is shared between processes, its atomics must not hide a lock.
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared frame sequences need lock-free 64-bit atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared frame flags need lock-free 32-bit atomics");
+
+// Slots start on page boundaries.
+static constexpr uint64_t __shared_align = 4096;
+
+static uint64_t alignUp(uint64_t size) {
+    return (size + __shared_align - 1) / __shared_align * __shared_align;
+}
+
+SharedFramebuffer::~SharedFramebuffer() {
+    close();
+}
+
+bool SharedFramebuffer::open(char const* name_, int width, int height, PixelFormat format) {
+    close();
+#ifdef SHARED_POSIX
+    uint64_t pixelOffset = alignUp(sizeof(SharedFrameHeader));
+    uint64_t slotBytes = alignUp((uint64_t)width * height * sizeof(uint32_t));
+    size_t total = pixelOffset + slotBytes * SharedFrameHeader::slots;
+
+    // A segment left by a crashed run is replaced, readers of it keep their old mapping.
+    shm_unlink(name_);
+    int fd = shm_open(name_, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        perror("shm_open");
+        return false;
+    }
+    void *memory = MAP_FAILED;
+    if (ftruncate(fd, total) == 0) {
+        memory = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        perror("shared framebuffer");
+        shm_unlink(name_);
+        return false;
+    }
+
+    header = new (memory) SharedFrameHeader;
+    header->width = width;
+    header->height = height;
+    header->format = (int32_t)format;
+    header->slotCount = SharedFrameHeader::slots;
+    header->pixelOffset = pixelOffset;
+    header->slotBytes = slotBytes;
+    header->frames.store(0, std::memory_order_relaxed);
+    header->closed.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < SharedFrameHeader::slots; ++i) {
+        header->sequence[i].store(0, std::memory_order_relaxed);
+        header->frame[i].store(0, std::memory_order_relaxed);
+        // Every slot misses the whole first frame.
+        pending[i].clear();
+        pending[i].add({ 0, 0, width, height });
+    }
+    header->version = SharedFrameHeader::revision;
+    // Readers check magic last.
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SharedFrameHeader::tag;
+
+    size = total;
+    snprintf(name, sizeof(name), "%s", name_);
+    return true;
+#else
+    (void)name_;
+    (void)width;
+    (void)height;
+    (void)format;
+    fprintf(stderr, "Shared framebuffers need POSIX shared memory\n");
+    return false;
+#endif
+}
+
+void SharedFramebuffer::close() {
+    if (!header) return;
+#ifdef SHARED_POSIX
+    header->closed.store(1, std::memory_order_release);
+    munmap(header, size);
+    shm_unlink(name);
+#endif
+    header = nullptr;
+    size = 0;
+}
+
+void SharedFramebuffer::publish(Image const& image, Rect const* rects, int count) {
+    if (!header) return;
+    int const width = header->width;
+    int const height = header->height;
+
+    for (int s = 0; s < SharedFrameHeader::slots; ++s) {
+        for (int i = 0; i < count; ++i) pending[s].add(rects[i]);
+    }
+
+    uint64_t frame = header->frames.load(std::memory_order_relaxed) + 1;
+    int slot = (int)((frame - 1) % SharedFrameHeader::slots);
+    uint32_t *pixels = (uint32_t*)((char*)header + header->pixelOffset + header->slotBytes * slot);
+
+    // Odd while writing, a reader seeing it or a changed value drops what it read.
+    uint64_t sequence = header->sequence[slot].load(std::memory_order_relaxed);
+    header->sequence[slot].store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    DirtyRegion & p = pending[slot];
+    for (int i = 0; i < p.count; ++i) {
+        Rect r = p.rects[i];
+        r.x0 = std::max(r.x0, 0);
+        r.y0 = std::max(r.y0, 0);
+        r.x1 = std::min(r.x1, std::min(width, image.width));
+        r.y1 = std::min(r.y1, std::min(height, image.height));
+        if (r.empty()) continue;
+        for (int y = r.y0; y < r.y1; ++y) {
+            copySpan(pixels + (size_t)y * width + r.x0, image.data + (size_t)y * image.stride + r.x0, r.x1 - r.x0);
+        }
+    }
+    p.clear();
+
+    header->frame[slot].store(frame, std::memory_order_relaxed);
+    header->sequence[slot].store(sequence + 2, std::memory_order_release);
+    header->frames.store(frame, std::memory_order_release);
+}
+
+SharedFrameReader::~SharedFrameReader() {
+    close();
+}
+
+bool SharedFrameReader::open(char const* name) {
+    close();
+#ifdef SHARED_POSIX
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat info;
+    void *memory = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(SharedFrameHeader)) {
+        memory = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED) return false;
+
+    auto const* h = (SharedFrameHeader const*)memory;
+    if (h->magic != SharedFrameHeader::tag || h->version != SharedFrameHeader::revision
+        || h->pixelOffset + h->slotBytes * h->slotCount > (uint64_t)info.st_size) {
+        munmap(memory, info.st_size);
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    header = h;
+    size = info.st_size;
+    return true;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+void SharedFrameReader::close() {
+    if (!header) return;
+#ifdef SHARED_POSIX
+    munmap((void*)header, size);
+#endif
+    header = nullptr;
+    size = 0;
+}
+
+int SharedFrameReader::begin(uint64_t & sequence) const {
+    uint64_t frames = header->frames.load(std::memory_order_acquire);
+    if (frames == 0) return -1;
+    int slot = (int)((frames - 1) % header->slotCount);
+    sequence = header->sequence[slot].load(std::memory_order_acquire);
+    return sequence & 1 ? -1 : slot;
+}
+
+bool SharedFrameReader::validate(int slot, uint64_t sequence) const {
+    // Pixel reads must not move past the second sequence read.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header->sequence[slot].load(std::memory_order_relaxed) == sequence;
+}
+
+uint64_t SharedFrameReader::frame(int slot) const {
+    return header->frame[slot].load(std::memory_order_relaxed);
+}
+
+uint32_t const* SharedFrameReader::pixels(int slot) const {
+    return (uint32_t const*)((char const*)header + header->pixelOffset + header->slotBytes * slot);
+}
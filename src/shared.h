@@ -0,0 +1,98 @@
+#ifndef _SHARED_H
+#define _SHARED_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "image.h"
+
+/**
+ * Layout of a framebuffer exported to POSIX shared memory, readers map it read-only.
+ * - Frames are published into slots in turns, the last one is in slot (frames - 1) % slots.
+ * - Each slot is guarded by a seqlock: sequence is odd while the game writes the slot. A reader
+ *   reads sequence, the pixels, then sequence again, and the pixels are one frame if both are
+ *   the same even number. The game never waits for readers, a slow reader just retries.
+ * - Pixels of a slot are width x height packed words in format, rows are not padded.
+ */
+struct SharedFrameHeader {
+    static constexpr uint32_t tag = 0x42465242u; // "BRFB" in memory
+    static constexpr uint32_t revision = 1;
+    static constexpr int slots = 3;
+
+    uint32_t magic;
+    uint32_t version;
+    int32_t width, height;
+    // PixelFormat of the pixels.
+    int32_t format;
+    int32_t slotCount;
+    // Bytes from the start of the segment to slot 0, and between slots.
+    uint64_t pixelOffset;
+    uint64_t slotBytes;
+    // Frames published so far.
+    std::atomic<uint64_t> frames;
+    // Set when the game closed the segment, no frame follows.
+    std::atomic<uint32_t> closed;
+    std::atomic<uint64_t> sequence[slots];
+    // Frame number held by each slot, read inside the seqlock.
+    std::atomic<uint64_t> frame[slots];
+};
+
+/**
+ * Game side of the export, a copy of the presented framebuffer in a named segment.
+ * - publish copies what changed into the next slot, the rects of this frame plus those
+ *   of the frames that went into the other slots since.
+ * - The segment is unlinked on close, readers keep their mapping until they unmap it.
+ */
+struct SharedFramebuffer {
+    SharedFramebuffer() = default;
+    ~SharedFramebuffer();
+    SharedFramebuffer(SharedFramebuffer const&) = delete;
+    SharedFramebuffer & operator=(SharedFramebuffer const&) = delete;
+
+    // Create or replace segment name, e.g. "/bricks", for frames of this size and format.
+    bool open(char const* name, int width, int height, PixelFormat format);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    // Publish image, which changed only inside count rects in memory rows since the last call.
+    void publish(Image const& image, Rect const* rects, int count);
+
+private:
+    SharedFrameHeader *header = nullptr;
+    size_t size = 0;
+    char name[64] = {};
+    // What each slot misses before it holds the current frame, overlaps are merged so nothing is copied twice.
+    DirtyRegion pending[SharedFrameHeader::slots];
+};
+
+/**
+ * Reader side, used by tools/frameview.cpp, maps a segment read-only.
+ * A consistent frame is read as:
+ *     uint64_t sequence;
+ *     int slot = reader.begin(sequence);
+ *     if (slot >= 0) { read reader.pixels(slot)...; if (reader.validate(slot, sequence)) use it; }
+ */
+struct SharedFrameReader {
+    SharedFrameHeader const* header = nullptr;
+
+    SharedFrameReader() = default;
+    ~SharedFrameReader();
+    SharedFrameReader(SharedFrameReader const&) = delete;
+    SharedFrameReader & operator=(SharedFrameReader const&) = delete;
+
+    bool open(char const* name);
+    void close();
+
+    // Slot of the last published frame, or -1 when none was or it is being written.
+    int begin(uint64_t & sequence) const;
+    // True when the slot was not written to since begin returned sequence.
+    bool validate(int slot, uint64_t sequence) const;
+    // Frame number of the slot, read between begin and validate.
+    uint64_t frame(int slot) const;
+    uint32_t const* pixels(int slot) const;
+
+private:
+    size_t size = 0;
+};
+
+#endif
@@ -0,0 +1,482 @@
+#include "span.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SPAN_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Kernels above the baseline are compiled per function, so the binary still runs on any x86.
+#if defined(__GNUC__) || defined(__clang__)
+#define SPAN_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SPAN_TARGET(isa)
+#endif
+
+// Spans longer than this are cleared with streaming stores (256 KB).
+constexpr int __stream_threshold = 64 * 1024;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Scalar
+
+static void fillScalar(uint32_t *dst, int count, uint32_t pixel) {
+    for (int i = 0; i < count; ++i) dst[i] = pixel;
+}
+
+static void compositeScalar(uint32_t *dst, uint32_t const* src, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (src[i]) dst[i] = src[i];
+    }
+}
+
+static void copyScalar(uint32_t *dst, uint32_t const* src, int count) {
+    memcpy(dst, src, count * sizeof(uint32_t));
+}
+
+static void swizzleRGBScalar(uint32_t *dst, uint8_t const* src, int count, bool bgr) {
+    int r = bgr ? 16 : 0;
+    int b = bgr ? 0 : 16;
+    for (int i = 0; i < count; ++i, src += 3) {
+        dst[i] = ((uint32_t)src[0] << r) | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << b) | (0xFFu << 24);
+    }
+}
+
+static void expandIndexedScalar(uint32_t *dst, uint8_t const* src, int count, uint32_t const* palette, int) {
+    for (int i = 0; i < count; ++i) dst[i] = palette[src[i]];
+}
+
+static void upscaleScalar(uint32_t *dst, uint32_t const* src, int count, int factor) {
+    for (int i = 0; i < count; ++i, dst += factor) {
+        for (int j = 0; j < factor; ++j) dst[j] = src[i];
+    }
+}
+
+#if defined(SPAN_X86)
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// SSE2
+
+SPAN_TARGET("sse2")
+static void fillSSE2(uint32_t *dst, int count, uint32_t pixel) {
+    // Scalar head until dst is 16-byte aligned, then 4 pixels per store.
+    while (count > 0 && ((uintptr_t)dst & 15)) {
+        *dst++ = pixel;
+        --count;
+    }
+    __m128i v = _mm_set1_epi32((int)pixel);
+    for (; count >= 8; count -= 8, dst += 8) {
+        _mm_store_si128((__m128i*)dst, v);
+        _mm_store_si128((__m128i*)(dst + 4), v);
+    }
+    if (count >= 4) {
+        _mm_store_si128((__m128i*)dst, v);
+        count -= 4;
+        dst += 4;
+    }
+    for (int i = 0; i < count; ++i) dst[i] = pixel;
+}
+
+SPAN_TARGET("sse2")
+static void clearSSE2(uint32_t *dst, int count, uint32_t pixel) {
+    if (count < __stream_threshold) return fillSSE2(dst, count, pixel);
+    while ((uintptr_t)dst & 15) {
+        *dst++ = pixel;
+        --count;
+    }
+    __m128i v = _mm_set1_epi32((int)pixel);
+    for (; count >= 4; count -= 4, dst += 4) _mm_stream_si128((__m128i*)dst, v);
+    _mm_sfence();
+    for (int i = 0; i < count; ++i) dst[i] = pixel;
+}
+
+SPAN_TARGET("sse2")
+static void compositeSSE2(uint32_t *dst, uint32_t const* src, int count) {
+    int i = 0;
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((__m128i const*)(src + i));
+        __m128i d = _mm_loadu_si128((__m128i const*)(dst + i));
+        __m128i empty = _mm_cmpeq_epi32(s, zero);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_and_si128(empty, d), _mm_andnot_si128(empty, s)));
+    }
+    compositeScalar(dst + i, src + i, count - i);
+}
+
+SPAN_TARGET("sse2")
+static void copySSE2(uint32_t *dst, uint32_t const* src, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_loadu_si128((__m128i const*)(src + i));
+        __m128i b = _mm_loadu_si128((__m128i const*)(src + i + 4));
+        _mm_storeu_si128((__m128i*)(dst + i), a);
+        _mm_storeu_si128((__m128i*)(dst + i + 4), b);
+    }
+    copyScalar(dst + i, src + i, count - i);
+}
+
+SPAN_TARGET("sse2")
+static void upscaleSSE2(uint32_t *dst, uint32_t const* src, int count, int factor) {
+    if (factor != 2 && factor != 4) return upscaleScalar(dst, src, count, factor);
+    int i = 0;
+    for (; i + 4 <= count; i += 4, dst += 4 * factor) {
+        __m128i s = _mm_loadu_si128((__m128i const*)(src + i));
+        if (factor == 2) {
+            _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi32(s, s));
+            _mm_storeu_si128((__m128i*)(dst + 4), _mm_unpackhi_epi32(s, s));
+        }
+        else {
+            _mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi32(s, 0x00));
+            _mm_storeu_si128((__m128i*)(dst + 4), _mm_shuffle_epi32(s, 0x55));
+            _mm_storeu_si128((__m128i*)(dst + 8), _mm_shuffle_epi32(s, 0xAA));
+            _mm_storeu_si128((__m128i*)(dst + 12), _mm_shuffle_epi32(s, 0xFF));
+        }
+    }
+    upscaleScalar(dst, src + i, count - i, factor);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// SSSE3
+
+// Byte shuffles moving 4 R, G, B triples into R, G, B, 0 or B, G, R, 0 words, 0x80 writes 0.
+#define SHUFFLE_RGB  15, 11, 10, 9, 15, 8, 7, 6, 15, 5, 4, 3, 15, 2, 1, 0
+#define SHUFFLE_BGR  15, 9, 10, 11, 15, 6, 7, 8, 15, 3, 4, 5, 15, 0, 1, 2
+
+SPAN_TARGET("ssse3")
+static void swizzleRGBSSSE3(uint32_t *dst, uint8_t const* src, int count, bool bgr) {
+    // _mm_set_epi8 lists bytes high to low, index 15 is then masked by the 0x80 bits below.
+    __m128i shuffle = bgr ? _mm_set_epi8(SHUFFLE_BGR) : _mm_set_epi8(SHUFFLE_RGB);
+    shuffle = _mm_or_si128(shuffle, _mm_set1_epi32((int)0x80000000));
+    __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    int i = 0;
+    // Each load reads 16 bytes for 12, stop while 4 spare bytes remain.
+    for (; i + 6 <= count; i += 4, src += 12) {
+        __m128i rgb = _mm_loadu_si128((__m128i const*)src);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+    }
+    swizzleRGBScalar(dst + i, src, count - i, bgr);
+}
+
+SPAN_TARGET("ssse3")
+static void expandIndexedSSSE3(uint32_t *dst, uint8_t const* src, int count, uint32_t const* palette, int size) {
+    if (size > 16) return expandIndexedScalar(dst, src, count, palette, size);
+
+    // One table per color byte, pshufb looks up 16 indices in each and the bytes are interleaved back.
+    alignas(16) uint8_t planes[4][16];
+    for (int c = 0; c < 16; ++c)
+    for (int b = 0; b < 4; ++b) {
+        planes[b][c] = (uint8_t)(palette[c] >> (8 * b));
+    }
+    __m128i p0 = _mm_load_si128((__m128i const*)planes[0]);
+    __m128i p1 = _mm_load_si128((__m128i const*)planes[1]);
+    __m128i p2 = _mm_load_si128((__m128i const*)planes[2]);
+    __m128i p3 = _mm_load_si128((__m128i const*)planes[3]);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i index = _mm_loadu_si128((__m128i const*)(src + i));
+        __m128i b0 = _mm_shuffle_epi8(p0, index);
+        __m128i b1 = _mm_shuffle_epi8(p1, index);
+        __m128i b2 = _mm_shuffle_epi8(p2, index);
+        __m128i b3 = _mm_shuffle_epi8(p3, index);
+        __m128i lo01 = _mm_unpacklo_epi8(b0, b1);
+        __m128i hi01 = _mm_unpackhi_epi8(b0, b1);
+        __m128i lo23 = _mm_unpacklo_epi8(b2, b3);
+        __m128i hi23 = _mm_unpackhi_epi8(b2, b3);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi16(lo01, lo23));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_unpackhi_epi16(lo01, lo23));
+        _mm_storeu_si128((__m128i*)(dst + i + 8), _mm_unpacklo_epi16(hi01, hi23));
+        _mm_storeu_si128((__m128i*)(dst + i + 12), _mm_unpackhi_epi16(hi01, hi23));
+    }
+    expandIndexedScalar(dst + i, src + i, count - i, palette, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// AVX2
+
+SPAN_TARGET("avx2")
+static void fillAVX2(uint32_t *dst, int count, uint32_t pixel) {
+    // Scalar head until dst is 32-byte aligned, then 8 pixels per store.
+    while (count > 0 && ((uintptr_t)dst & 31)) {
+        *dst++ = pixel;
+        --count;
+    }
+    __m256i v = _mm256_set1_epi32((int)pixel);
+    for (; count >= 16; count -= 16, dst += 16) {
+        _mm256_store_si256((__m256i*)dst, v);
+        _mm256_store_si256((__m256i*)(dst + 8), v);
+    }
+    if (count >= 8) {
+        _mm256_store_si256((__m256i*)dst, v);
+        count -= 8;
+        dst += 8;
+    }
+    for (int i = 0; i < count; ++i) dst[i] = pixel;
+}
+
+SPAN_TARGET("avx2")
+static void clearAVX2(uint32_t *dst, int count, uint32_t pixel) {
+    if (count < __stream_threshold) return fillAVX2(dst, count, pixel);
+    while ((uintptr_t)dst & 31) {
+        *dst++ = pixel;
+        --count;
+    }
+    __m256i v = _mm256_set1_epi32((int)pixel);
+    for (; count >= 8; count -= 8, dst += 8) _mm256_stream_si256((__m256i*)dst, v);
+    _mm_sfence();
+    for (int i = 0; i < count; ++i) dst[i] = pixel;
+}
+
+SPAN_TARGET("avx2")
+static void compositeAVX2(uint32_t *dst, uint32_t const* src, int count) {
+    int i = 0;
+    __m256i zero = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((__m256i const*)(src + i));
+        __m256i d = _mm256_loadu_si256((__m256i const*)(dst + i));
+        __m256i empty = _mm256_cmpeq_epi32(s, zero);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_blendv_epi8(s, d, empty));
+    }
+    compositeScalar(dst + i, src + i, count - i);
+}
+
+SPAN_TARGET("avx2")
+static void copyAVX2(uint32_t *dst, uint32_t const* src, int count) {
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_loadu_si256((__m256i const*)(src + i));
+        __m256i b = _mm256_loadu_si256((__m256i const*)(src + i + 8));
+        _mm256_storeu_si256((__m256i*)(dst + i), a);
+        _mm256_storeu_si256((__m256i*)(dst + i + 8), b);
+    }
+    copyScalar(dst + i, src + i, count - i);
+}
+
+SPAN_TARGET("avx2")
+static void swizzleRGBAVX2(uint32_t *dst, uint8_t const* src, int count, bool bgr) {
+    // Same shuffle as SSSE3 in both lanes, the high lane is loaded 12 bytes further.
+    __m128i lane = bgr ? _mm_set_epi8(SHUFFLE_BGR) : _mm_set_epi8(SHUFFLE_RGB);
+    __m256i shuffle = _mm256_or_si256(_mm256_broadcastsi128_si256(lane), _mm256_set1_epi32((int)0x80000000));
+    __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+    int i = 0;
+    for (; i + 10 <= count; i += 8, src += 24) {
+        __m128i lo = _mm_loadu_si128((__m128i const*)src);
+        __m128i hi = _mm_loadu_si128((__m128i const*)(src + 12));
+        __m256i rgb = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(_mm256_shuffle_epi8(rgb, shuffle), alpha));
+    }
+    swizzleRGBScalar(dst + i, src, count - i, bgr);
+}
+
+SPAN_TARGET("avx2")
+static void expandIndexedAVX2(uint32_t *dst, uint8_t const* src, int count, uint32_t const* palette, int size) {
+    if (size <= 16) return expandIndexedSSSE3(dst, src, count, palette, size);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const*)(src + i)));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_i32gather_epi32((int const*)palette, index, 4));
+    }
+    expandIndexedScalar(dst + i, src + i, count - i, palette, size);
+}
+
+SPAN_TARGET("avx2")
+static void upscaleAVX2(uint32_t *dst, uint32_t const* src, int count, int factor) {
+    if (factor < 2 || factor > 8) return upscaleScalar(dst, src, count, factor);
+
+    // 8 source pixels make factor stores of 8, lane l of store c repeats pixel (8c + l) / factor.
+    __m256i index[8];
+    for (int c = 0; c < factor; ++c) {
+        alignas(32) int lanes[8];
+        for (int l = 0; l < 8; ++l) lanes[l] = (8 * c + l) / factor;
+        index[c] = _mm256_load_si256((__m256i const*)lanes);
+    }
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((__m256i const*)(src + i));
+        for (int c = 0; c < factor; ++c, dst += 8) {
+            _mm256_storeu_si256((__m256i*)dst, _mm256_permutevar8x32_epi32(s, index[c]));
+        }
+    }
+    upscaleScalar(dst, src + i, count - i, factor);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// AVX-512, masked stores replace the scalar tails
+
+SPAN_TARGET("avx512f")
+static void fillAVX512(uint32_t *dst, int count, uint32_t pixel) {
+    __m512i v = _mm512_set1_epi32((int)pixel);
+    // Masked head up to 64-byte alignment.
+    int head = (int)((64 - ((uintptr_t)dst & 63)) & 63) / 4;
+    head = head < count ? head : count;
+    _mm512_mask_storeu_epi32(dst, (__mmask16)((1u << head) - 1), v);
+    dst += head;
+    count -= head;
+    for (; count >= 16; count -= 16, dst += 16) _mm512_store_si512(dst, v);
+    _mm512_mask_storeu_epi32(dst, (__mmask16)((1u << count) - 1), v);
+}
+
+SPAN_TARGET("avx512f")
+static void clearAVX512(uint32_t *dst, int count, uint32_t pixel) {
+    if (count < __stream_threshold) return fillAVX512(dst, count, pixel);
+    __m512i v = _mm512_set1_epi32((int)pixel);
+    int head = (int)((64 - ((uintptr_t)dst & 63)) & 63) / 4;
+    _mm512_mask_storeu_epi32(dst, (__mmask16)((1u << head) - 1), v);
+    dst += head;
+    count -= head;
+    for (; count >= 16; count -= 16, dst += 16) _mm512_stream_si512((__m512i*)dst, v);
+    _mm_sfence();
+    _mm512_mask_storeu_epi32(dst, (__mmask16)((1u << count) - 1), v);
+}
+
+SPAN_TARGET("avx512f")
+static void compositeAVX512(uint32_t *dst, uint32_t const* src, int count) {
+    // Store only the lanes that are not 0 in src.
+    for (int i = 0; i < count; i += 16) {
+        int n = count - i < 16 ? count - i : 16;
+        __mmask16 valid = (__mmask16)((1u << n) - 1);
+        __m512i s = _mm512_maskz_loadu_epi32(valid, src + i);
+        _mm512_mask_storeu_epi32(dst + i, _mm512_test_epi32_mask(s, s), s);
+    }
+}
+
+SPAN_TARGET("avx512f")
+static void copyAVX512(uint32_t *dst, uint32_t const* src, int count) {
+    for (int i = 0; i < count; i += 16) {
+        int n = count - i < 16 ? count - i : 16;
+        __mmask16 valid = (__mmask16)((1u << n) - 1);
+        _mm512_mask_storeu_epi32(dst + i, valid, _mm512_maskz_loadu_epi32(valid, src + i));
+    }
+}
+
+SPAN_TARGET("avx512f")
+static void expandIndexedAVX512(uint32_t *dst, uint8_t const* src, int count, uint32_t const* palette, int size) {
+    if (size > 16) return expandIndexedAVX2(dst, src, count, palette, size);
+
+    // The whole palette fits one register, vpermd looks up 16 indices at once.
+    __m512i colors = _mm512_loadu_si512(palette);
+    __mmask16 all = (__mmask16)0xFFFF;
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        // Zero-masked forms, the unmasked ones trip GCC's uninitialized warning.
+        __m512i index = _mm512_maskz_cvtepu8_epi32(all, _mm_loadu_si128((__m128i const*)(src + i)));
+        _mm512_storeu_si512(dst + i, _mm512_maskz_permutexvar_epi32(all, index, colors));
+    }
+    expandIndexedScalar(dst + i, src + i, count - i, palette, size);
+}
+
+#endif // SPAN_X86
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Registry
+
+static constexpr SpanKernels scalarKernels = {
+    fillScalar, fillScalar, compositeScalar, copyScalar, swizzleRGBScalar, expandIndexedScalar, upscaleScalar,
+};
+
+// Constant initialized from the constexpr table, so spans drawn by other static initializers use the scalar set.
+SpanKernels spanKernels = scalarKernels;
+static SimdTier currentTier = SimdTier::Scalar;
+
+SimdTier detectSimdTier() {
+#if defined(SPAN_X86)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int leaves = info[0];
+    __cpuid(info, 1);
+    bool sse2 = info[3] & (1 << 26);
+    bool ssse3 = info[2] & (1 << 9);
+    // The OS must save the wider registers as well, xcr0 says which ones it does.
+    unsigned long long xcr0 = (info[2] & (1 << 27)) ? _xgetbv(0) : 0;
+    bool avx2 = false;
+    bool avx512 = false;
+    if (leaves >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) && (xcr0 & 0x06) == 0x06;
+        avx512 = (info[1] & (1 << 16)) && (xcr0 & 0xE6) == 0xE6;
+    }
+#else
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool ssse3 = __builtin_cpu_supports("ssse3");
+    bool avx2 = __builtin_cpu_supports("avx2");
+    bool avx512 = __builtin_cpu_supports("avx512f");
+#endif
+    if (avx512 && avx2) return SimdTier::AVX512;
+    if (avx2 && ssse3) return SimdTier::AVX2;
+    if (ssse3 && sse2) return SimdTier::SSSE3;
+    if (sse2) return SimdTier::SSE2;
+#endif
+    return SimdTier::Scalar;
+}
+
+char const* simdTierName(SimdTier tier) {
+    switch (tier) {
+    case SimdTier::SSE2:   return "sse2";
+    case SimdTier::SSSE3:  return "ssse3";
+    case SimdTier::AVX2:   return "avx2";
+    case SimdTier::AVX512: return "avx512";
+    case SimdTier::Scalar:
+    default:               return "scalar";
+    }
+}
+
+SimdTier spanTier() {
+    return currentTier;
+}
+
+void selectSpanKernels(SimdTier tier) {
+    SimdTier best = detectSimdTier();
+    if (tier > best) tier = best;
+
+    // Each tier starts from the one below and replaces what it implements.
+    SpanKernels k = scalarKernels;
+#if defined(SPAN_X86)
+    if (tier >= SimdTier::SSE2) {
+        k.fill = fillSSE2;
+        k.clear = clearSSE2;
+        k.composite = compositeSSE2;
+        k.copy = copySSE2;
+        k.upscale = upscaleSSE2;
+    }
+    if (tier >= SimdTier::SSSE3) {
+        k.swizzleRGB = swizzleRGBSSSE3;
+        k.expandIndexed = expandIndexedSSSE3;
+    }
+    if (tier >= SimdTier::AVX2) {
+        k.fill = fillAVX2;
+        k.clear = clearAVX2;
+        k.composite = compositeAVX2;
+        k.copy = copyAVX2;
+        k.swizzleRGB = swizzleRGBAVX2;
+        k.expandIndexed = expandIndexedAVX2;
+        k.upscale = upscaleAVX2;
+    }
+    if (tier >= SimdTier::AVX512) {
+        k.fill = fillAVX512;
+        k.clear = clearAVX512;
+        k.composite = compositeAVX512;
+        k.copy = copyAVX512;
+        k.expandIndexed = expandIndexedAVX512;
+    }
+#endif
+    spanKernels = k;
+    currentTier = tier;
+}
+
+static SimdTier startupTier() {
+    SimdTier tier = SimdTier::AVX512;
+    if (char const* name = getenv("BRICKS_SIMD")) {
+        for (int t = (int)SimdTier::Scalar; t <= (int)SimdTier::AVX512; ++t) {
+            if (strcmp(name, simdTierName((SimdTier)t)) == 0) tier = (SimdTier)t;
+        }
+    }
+    selectSpanKernels(tier);
+    return currentTier;
+}
+
+static SimdTier const selectedAtStartup = startupTier();
@@ -0,0 +1,81 @@
+#ifndef _SPAN_H
+#define _SPAN_H
+
+#include <cstdint>
+
+// Span kernels write runs of packed 32-bit pixels.
+// Callers clip and pack colors beforehand, kernels do no bounds checking.
+
+// Instruction set tiers, each one implies the ones before it.
+enum struct SimdTier {
+    Scalar,
+    SSE2,
+    SSSE3,
+    AVX2,
+    AVX512,
+};
+
+/**
+ * Kernels bound for the running CPU.
+ * - Starts as the scalar set, the best tier the CPU supports is selected before main.
+ * - BRICKS_SIMD=scalar|sse2|ssse3|avx2|avx512 caps the tier, for testing slower paths.
+ */
+struct SpanKernels {
+    void (*fill)(uint32_t *dst, int count, uint32_t pixel);
+    void (*clear)(uint32_t *dst, int count, uint32_t pixel);
+    void (*composite)(uint32_t *dst, uint32_t const* src, int count);
+    void (*copy)(uint32_t *dst, uint32_t const* src, int count);
+    void (*swizzleRGB)(uint32_t *dst, uint8_t const* src, int count, bool bgr);
+    void (*expandIndexed)(uint32_t *dst, uint8_t const* src, int count, uint32_t const* palette, int size);
+    void (*upscale)(uint32_t *dst, uint32_t const* src, int count, int factor);
+};
+extern SpanKernels spanKernels;
+
+// Tier of the bound kernels.
+SimdTier spanTier();
+// Best tier this CPU and OS support.
+SimdTier detectSimdTier();
+char const* simdTierName(SimdTier tier);
+// Rebind kernels to tier, capped at detectSimdTier(). Not thread-safe, call while nothing draws.
+void selectSpanKernels(SimdTier tier);
+
+// Write pixel to dst[0, count).
+inline void fillSpan(uint32_t *dst, int count, uint32_t pixel) {
+    spanKernels.fill(dst, count, pixel);
+}
+
+// Like fillSpan, for whole buffers: large counts bypass the cache with streaming stores.
+inline void clearSpan(uint32_t *dst, int count, uint32_t pixel) {
+    spanKernels.clear(dst, count, pixel);
+}
+
+// Copy src[0, count) over dst[0, count), skipping pixels that are 0 in src.
+inline void compositeSpan(uint32_t *dst, uint32_t const* src, int count) {
+    spanKernels.composite(dst, src, count);
+}
+
+// Copy src[0, count) to dst[0, count), the ranges must not overlap.
+inline void copySpan(uint32_t *dst, uint32_t const* src, int count) {
+    spanKernels.copy(dst, src, count);
+}
+
+// Expand count 24-bit R, G, B pixels to opaque packed pixels, B, G, R, X in memory with bgr.
+inline void swizzleRGBSpan(uint32_t *dst, uint8_t const* src, int count, bool bgr) {
+    spanKernels.swizzleRGB(dst, src, count, bgr);
+}
+
+// Write each of src[0, count) factor times to dst[0, count * factor).
+inline void upscaleSpan(uint32_t *dst, uint32_t const* src, int count, int factor) {
+    spanKernels.upscale(dst, src, count, factor);
+}
+
+/**
+ * Look up count palette indices, dst[i] = palette[src[i]].
+ * - palette holds size colors, at least 16 entries must be readable.
+ * - Palettes of up to 16 colors are looked up in registers, larger ones are gathered.
+ */
+inline void expandIndexedSpan(uint32_t *dst, uint8_t const* src, int count, uint32_t const* palette, int size) {
+    spanKernels.expandIndexed(dst, src, count, palette, size);
+}
+
+#endif
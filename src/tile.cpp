@@ -0,0 +1,90 @@
+#include "tile.h"
+
+TileRenderer::TileRenderer(int tileSize_, int threads)
+    : tileSize(tileSize_)
+    , threadCount(threads > 0 ? threads : (int)std::thread::hardware_concurrency()) {
+    threadCount = std::max(threadCount, 1);
+}
+
+TileRenderer::~TileRenderer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto & worker : workers) worker.join();
+}
+
+// Workers are spawned on first use, the calling thread is one of the threadCount rasterizers.
+void TileRenderer::start() {
+    for (int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&TileRenderer::work, this);
+    }
+}
+
+void TileRenderer::work() {
+    int seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+        rasterizeTiles();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--running == 0) done.notify_one();
+        }
+    }
+}
+
+void TileRenderer::rasterizeTiles() {
+    int count = tilesX * tilesY;
+    for (int t = nextTile++; t < count; t = nextTile++) {
+        auto const& bin = bins[t];
+        if (bin.empty()) continue;
+        int tx = t % tilesX;
+        int ty = t / tilesX;
+        auto tile = image->view().sub({
+            tx * tileSize, ty * tileSize, (tx + 1) * tileSize, (ty + 1) * tileSize,
+        });
+        for (int i : bin) buffer->execute(tile, buffer->commands[i]);
+    }
+}
+
+void TileRenderer::execute(Image & image_, CommandBuffer const& buffer_) {
+    if (workers.empty() && threadCount > 1) start();
+
+    image = &image_;
+    buffer = &buffer_;
+    tilesX = (image->width + tileSize - 1) / tileSize;
+    tilesY = (image->height + tileSize - 1) / tileSize;
+    bins.resize(tilesX * tilesY);
+    for (auto & bin : bins) bin.clear();
+
+    auto const& commands = buffer->commands;
+    for (int i = 0; i < (int)commands.size(); ++i) {
+        auto const& b = commands[i].bounds;
+        int x0 = std::max(b.x0, 0);
+        int y0 = std::max(b.y0, 0);
+        int x1 = std::min(b.x1, image->width);
+        int y1 = std::min(b.y1, image->height);
+        if (x0 >= x1 || y0 >= y1) continue;
+        for (int ty = y0 / tileSize; ty <= (y1 - 1) / tileSize; ++ty)
+        for (int tx = x0 / tileSize; tx <= (x1 - 1) / tileSize; ++tx) {
+            bins[ty * tilesX + tx].push_back(i);
+        }
+    }
+
+    nextTile = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = (int)workers.size();
+        ++generation;
+    }
+    wake.notify_all();
+    rasterizeTiles();
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return running == 0; });
+}
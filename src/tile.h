@@ -0,0 +1,49 @@
+#ifndef _TILE_H
+#define _TILE_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include "image.h"
+#include "command.h"
+
+/**
+ * Tile-binned parallel executor for a CommandBuffer.
+ * - The image is split into tileSize x tileSize tiles (64 x 64 x 4 bytes fits in L1),
+ *   every command is binned into the tiles its bounds overlap.
+ * - Tiles are rasterized on a worker pool, each executing its bin in recording
+ *   order clipped to the tile, so the result is identical to executing serially.
+ */
+struct TileRenderer {
+    TileRenderer(int tileSize = 64, int threads = 0);
+    ~TileRenderer();
+
+    void execute(Image & image, CommandBuffer const& buffer);
+
+    int tileSize;
+
+private:
+    void start();
+    void work();
+    void rasterizeTiles();
+
+    int threadCount;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    int generation = 0;
+    int running = 0;
+    bool quit = false;
+
+    // Current job.
+    Image *image = nullptr;
+    CommandBuffer const* buffer = nullptr;
+    int tilesX = 0, tilesY = 0;
+    std::vector<std::vector<int>> bins;
+    std::atomic<int> nextTile;
+};
+
+#endif
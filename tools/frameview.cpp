@@ -0,0 +1,162 @@
+// Reference reader of the framebuffer Bricks exports with --share.
+// Frames are read straight from the read-only mapping and kept only when the slot's seqlock
+// shows the game did not write it meanwhile, the game never waits for this tool.
+//
+// usage: frameview [name]                     show frames in a window as they are published
+//        frameview --dump file.ppm [name]     write the last frame to a PPM file
+//        frameview --record prefix n [name]   write the next n frames to prefix0000.ppm, prefix0001.ppm...
+// name is "/bricks" by default.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "platform.h"
+#include "shared.h"
+#include "span.h"
+
+using namespace LuGL;
+
+// Frames are polled for, the game does not signal readers.
+static void nap() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+// Read the last frame through convert, which gets each source row in turn, and return its number.
+// Waits for a frame newer than after and retries until it is read whole.
+// Returns 0 if the game closed the segment without publishing one.
+template<typename Convert>
+static uint64_t readFrame(SharedFrameReader const& reader, uint64_t after, Convert convert) {
+    int const width = reader.header->width;
+    for (;;) {
+        // Checked first, the last frame is published before the segment is closed.
+        bool closed = reader.header->closed.load(std::memory_order_acquire);
+        uint64_t sequence;
+        int slot = reader.begin(sequence);
+        if (slot < 0 || reader.frame(slot) <= after) {
+            if (closed) return 0;
+            nap();
+            continue;
+        }
+        uint64_t frame = reader.frame(slot);
+        uint32_t const* pixels = reader.pixels(slot);
+        for (int y = 0; y < reader.header->height; ++y) convert(y, pixels + (size_t)y * width);
+        if (reader.validate(slot, sequence)) return frame;
+    }
+}
+
+static bool writePPM(SharedFrameReader const& reader, char const* path, uint64_t & frame) {
+    int const width = reader.header->width;
+    int const height = reader.header->height;
+    bool const bgr = reader.header->format == (int32_t)PixelFormat::BGRX;
+    std::vector<unsigned char> rgb((size_t)width * height * 3);
+    frame = readFrame(reader, frame, [&](int y, uint32_t const* row) {
+        unsigned char *dst = &rgb[(size_t)y * width * 3];
+        for (int x = 0; x < width; ++x) {
+            uint32_t p = row[x];
+            unsigned char c0 = p & 0xFF, c1 = (p >> 8) & 0xFF, c2 = (p >> 16) & 0xFF;
+            dst[x * 3 + 0] = bgr ? c2 : c0;
+            dst[x * 3 + 1] = c1;
+            dst[x * 3 + 2] = bgr ? c0 : c2;
+        }
+    });
+    if (!frame) return false;
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return false;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    fwrite(rgb.data(), 1, rgb.size(), file);
+    fclose(file);
+    return true;
+}
+
+static void view(SharedFrameReader const& reader) {
+    int const width = reader.header->width;
+    int const height = reader.header->height;
+    initializeApplication();
+    // Red and blue are swapped when this window's format is not the game's.
+    bool const swap = (getSurfaceFormat() == PIXEL_BGRX) != (reader.header->format == (int32_t)PixelFormat::BGRX);
+    std::vector<uint32_t> surface((size_t)width * height);
+    AppWindow *window = createWindow("Bricks viewer", width, height, (byte_t*)surface.data(), width);
+
+    uint64_t frame = 0;
+    while (window && !windowShouldClose(window)) {
+        uint64_t sequence;
+        int slot = reader.begin(sequence);
+        if (slot >= 0 && reader.frame(slot) > frame) {
+            uint64_t next = reader.frame(slot);
+            uint32_t const* pixels = reader.pixels(slot);
+            if (swap) {
+                for (size_t i = 0; i < surface.size(); ++i) {
+                    uint32_t p = pixels[i];
+                    surface[i] = (p & 0xFF00FF00u) | ((p >> 16) & 0xFFu) | ((p & 0xFFu) << 16);
+                }
+            }
+            else {
+                copySpan(surface.data(), pixels, width * height);
+            }
+            // A torn copy is not shown, the next poll reads a newer frame.
+            if (reader.validate(slot, sequence)) {
+                frame = next;
+                swapBuffer(window);
+            }
+        }
+        else {
+            if (reader.header->closed.load(std::memory_order_acquire)) break;
+            nap();
+        }
+        pollEvent();
+    }
+    printf("Last frame shown: %llu\n", (unsigned long long)frame);
+    terminateApplication();
+}
+
+int main(int argc, char* argv[]) {
+    char const* dump = nullptr;
+    char const* prefix = nullptr;
+    int count = 0;
+    char const* name = "/bricks";
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) dump = argv[++i];
+        else if (strcmp(argv[i], "--record") == 0 && i + 2 < argc) {
+            prefix = argv[++i];
+            count = atoi(argv[++i]);
+        }
+        else name = argv[i];
+    }
+
+    SharedFrameReader reader;
+    if (!reader.open(name)) {
+        fprintf(stderr, "Cannot map %s, is Bricks running with --share?\n", name);
+        return 1;
+    }
+
+    if (dump) {
+        uint64_t frame = 0;
+        if (!writePPM(reader, dump, frame)) return 1;
+        printf("Frame %llu written to %s\n", (unsigned long long)frame, dump);
+    }
+    else if (prefix) {
+        uint64_t frame = 0;
+        int written = 0;
+        for (; written < count; ++written) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s%04d.ppm", prefix, written);
+            uint64_t last = frame;
+            if (!writePPM(reader, path, frame)) break;
+            // Frames published while one was written are not recorded.
+            if (last && frame > last + 1) printf("Frames %llu to %llu missed\n", (unsigned long long)last + 1, (unsigned long long)frame - 1);
+        }
+        printf("%d frames written to %s*.ppm\n", written, prefix);
+    }
+    else {
+        view(reader);
+    }
+    return 0;
+}